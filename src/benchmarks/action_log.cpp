@@ -0,0 +1,98 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <robox2d/action_log.hpp>
+#include <robox2d/hash.hpp>
+
+#include "bench_robots.hpp"
+
+// Size of an action-only log (seed + delta-encoded commands + world hashes) vs a full state log, cost of recording,
+// and check that the replay is bit-for-bit identical (and that a perturbation is detected at the right tick).
+
+namespace {
+  class Sine : public robox2d::control::BaseController {
+  public:
+    Sine(size_t nb_dofs, uint64_t seed) : BaseController(nb_dofs), _phase(nb_dofs)
+    {
+      std::mt19937_64 gen(seed);
+      std::uniform_real_distribution<double> dist(0.0, 2.0 * M_PI);
+      for (size_t i = 0; i < nb_dofs; i++)
+	_phase[i] = dist(gen);
+    }
+
+    void write_commands(double t, robox2d::Robot* robot, Eigen::Ref<Eigen::VectorXd> cmd) override
+    {
+      for (size_t i = 0; i < _nb_dofs; i++)
+	cmd[i] = 0.5 * std::sin(2.0 * t + _phase[i]);
+    }
+
+  private:
+    std::vector<double> _phase;
+  };
+
+  std::shared_ptr<robox2d::Simu> make_simu(uint64_t seed)
+  {
+    auto simu = std::make_shared<robox2d::Simu>(100, 50, 50);
+    simu->add_floor();
+    auto rob = std::make_shared<bench::Arm>(simu->world(), 8);
+    rob->add_controller(std::make_shared<Sine>(8, seed));
+    simu->add_robot(rob);
+    return simu;
+  }
+}
+
+int main()
+{
+  const double duration = 600.0;
+  const uint64_t seed = 42;
+  const std::string filename = "bench_action_log.bin";
+
+  double t_plain = bench::timeit([&]() { make_simu(seed)->run(duration); });
+
+  auto simu = make_simu(seed);
+  auto log = std::make_shared<robox2d::ActionLog>();
+  log->seed = seed;
+  log->config = "arm 8";
+  double t_record = bench::timeit([&]() {
+    simu->set_action_logger(std::make_shared<robox2d::ActionLogger>(robox2d::ActionLogger::Record, log));
+    simu->run(duration);
+  });
+  log->save(filename);
+  uint64_t final_hash = robox2d::world_hash(*simu->world());
+
+  size_t nb_steps = log->hashes.size() * log->hash_period;
+  size_t nb_bodies = simu->world()->GetBodyCount(), nb_joints = simu->world()->GetJointCount();
+  size_t full_size = nb_steps * (sizeof(double) + sizeof(float) * (3 * nb_bodies + nb_joints + 8));
+
+  // replay from the file, in a simu rebuilt from the seed
+  auto loaded = std::make_shared<robox2d::ActionLog>();
+  loaded->load(filename);
+  auto replay_simu = make_simu(loaded->seed);
+  auto replayer = std::make_shared<robox2d::ActionLogger>(robox2d::ActionLogger::Replay, loaded);
+  replay_simu->set_action_logger(replayer);
+  robox2d::RunResult result = replay_simu->run(duration);
+  bool identical = result.reason == robox2d::RunResult::Duration && robox2d::world_hash(*replay_simu->world()) == final_hash;
+
+  // perturbed replay: nudge the last created body after 100 s
+  auto perturbed = make_simu(loaded->seed);
+  auto perturbed_replayer = std::make_shared<robox2d::ActionLogger>(robox2d::ActionLogger::Replay, loaded);
+  perturbed->set_action_logger(perturbed_replayer);
+  perturbed->run(100.0);
+  b2Body* body = perturbed->world()->GetBodyList();
+  body->SetLinearVelocity(body->GetLinearVelocity() + b2Vec2(1e-6f, 0.0f));
+  size_t perturbation_tick = perturbed->tick();
+  result = perturbed->run(duration - 100.0);
+
+  std::cout << "steps: " << nb_steps << ", action log: " << log->nb_bytes() / 1024.0 << " KiB (" << log->hashes.size() * sizeof(robox2d::HashStream::Entry) / 1024.0
+	    << " KiB of hashes), full state log: " << full_size / 1024.0 << " KiB" << std::endl;
+  std::cout << "run: " << 1e6 * t_plain / nb_steps << " us/step, recording: " << 1e6 * t_record / nb_steps << " us/step" << std::endl;
+  std::cout << "replay identical: " << (identical ? "yes" : "NO") << std::endl;
+  std::cout << "perturbation at tick " << perturbation_tick << ", divergence detected at tick " << perturbed_replayer->divergence_tick()
+	    << (result.reason == robox2d::RunResult::Diverged ? " (run stopped)" : "") << std::endl;
+  std::remove(filename.c_str());
+
+  // the replay must be identical and the perturbation caught (the run fails otherwise)
+  bool detected = result.reason == robox2d::RunResult::Diverged && perturbed_replayer->divergence_tick() > perturbation_tick;
+  return (identical && detected) ? 0 : 1;
+}
@@ -0,0 +1,31 @@
+#include <iostream>
+
+#include "bench_robots.hpp"
+
+// Servo updates through the ServoBank (SoA, vectorized servo law) vs one virtual update() per actuator,
+// on arms with N joints.
+
+int main()
+{
+  const size_t nb_updates = 20000;
+  for (size_t nb_joints : {8, 32, 128, 512}) {
+    double t[2];
+    double steps[2];
+    for (int banks = 0; banks < 2; banks++) {
+      auto simu = bench::make_arm_simu(100, 50, 50, nb_joints);
+      auto robot = simu->robot(0);
+      robot->enable_actuator_banks(banks);
+      robot->control_update(0.0);
+      robot->physic_update(); // builds the banks
+      t[banks] = bench::timeit([&]() {
+	for (size_t i = 0; i < nb_updates; i++)
+	  robot->physic_update();
+      });
+      steps[banks] = 5.0 * 100 / bench::timeit([&]() { simu->run(5.0); });
+    }
+    std::cout << nb_joints << " joints: per actuator " << 1e9 * t[0] / (nb_updates * nb_joints) << " ns -> "
+	      << 1e9 * t[1] / (nb_updates * nb_joints) << " ns with banks (" << t[0] / t[1] << "x), "
+	      << "simu " << steps[0] << " -> " << steps[1] << " steps/s" << std::endl;
+  }
+  return 0;
+}
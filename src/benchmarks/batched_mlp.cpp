@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+#include <robox2d/control/mlp.hpp>
+#include <robox2d/simu_pool.hpp>
+
+#include "bench_robots.hpp"
+
+// Neural controllers of many arms: one MLPController per robot (one matrix-vector product per layer and robot)
+// vs a BatchedMLP (one matrix product per layer for all the robots), within one simu and across a SimuPool.
+
+namespace {
+  const size_t nb_joints = 8;
+
+  // joint positions and velocities
+  void arm_observation(robox2d::Robot& robot, Eigen::Ref<Eigen::VectorXf> input)
+  {
+    input.head(nb_joints) = robot.positions().cast<float>();
+    input.tail(nb_joints) = robot.velocities().cast<float>();
+  }
+
+  std::shared_ptr<robox2d::control::MLP> make_mlp()
+  {
+    auto mlp = std::make_shared<robox2d::control::MLP>(std::vector<size_t>{2 * nb_joints, 64, 64, nb_joints});
+    mlp->randomize(0);
+    return mlp;
+  }
+
+  // nb_robots arms side by side in one world, without controller
+  std::shared_ptr<robox2d::Simu> make_arms(size_t nb_robots)
+  {
+    auto simu = std::make_shared<robox2d::Simu>(100, 50, 50);
+    simu->add_floor();
+    for (size_t i = 0; i < nb_robots; i++)
+      simu->add_robot(std::make_shared<bench::Arm>(simu->world(), nb_joints, b2Vec2(3.0f * i, 0.0f)));
+    return simu;
+  }
+}
+
+int main()
+{
+  auto mlp = make_mlp();
+  const double scale = 0.1; // not a power of 2: both paths must scale in double precision
+
+  // cost of the control updates of one simu (no physics)
+  std::cout << "control update of N arms (network " << 2 * nb_joints << "-64-64-" << nb_joints << ", float32)" << std::endl;
+  for (size_t nb_robots : {1, 10, 100, 1000}) {
+    auto single = make_arms(nb_robots);
+    for (auto& robot : single->robots())
+      robot->add_controller(std::make_shared<robox2d::control::MLPController>(mlp, scale, arm_observation));
+    auto batched = make_arms(nb_robots);
+    auto batch = std::make_shared<robox2d::control::BatchedMLP>(mlp, scale, arm_observation);
+    batch->add_robots(*batched);
+
+    const size_t nb_updates = std::max<size_t>(10, 100000 / nb_robots);
+    double t_single = bench::timeit([&]() {
+      for (size_t k = 0; k < nb_updates; k++)
+	for (auto& robot : single->robots())
+	  robot->control_update(0.0);
+    });
+    double t_batched = bench::timeit([&]() {
+      for (size_t k = 0; k < nb_updates; k++) {
+	batch->update();
+	for (auto& robot : batched->robots())
+	  robot->control_update(0.0);
+      }
+    });
+
+    // both paths compute the same commands (up to the rounding of the products)
+    double max_error = 0.0;
+    for (size_t i = 0; i < nb_robots; i++)
+      max_error = std::max(max_error, (single->robot(i)->commands() - batched->robot(i)->commands()).cwiseAbs().maxCoeff());
+
+    std::cout << "  " << nb_robots << " robots: per robot " << 1e9 * t_single / (nb_updates * nb_robots) << " ns/robot, batched "
+	      << 1e9 * t_batched / (nb_updates * nb_robots) << " ns/robot (" << t_single / t_batched << "x), max difference " << max_error
+	      << std::endl;
+  }
+
+  // episodes of a pool, the batch gathering the robots of all the environments at each control tick
+  const size_t nb_threads = std::max(1u, std::thread::hardware_concurrency());
+  const size_t nb_episodes = 256;
+  const double duration = 2.0;
+  auto evaluator = [](robox2d::Simu& simu, size_t, double* result) { result[0] = simu.robot(0)->positions().sum(); };
+  std::cout << "SimuPool of arms (" << nb_episodes << " episodes of " << duration << "s, " << nb_threads << " threads, lockstep)" << std::endl;
+  for (size_t nb_envs : {nb_threads, 4 * nb_threads, 16 * nb_threads}) {
+    robox2d::SimuPool single(nb_envs, [&](size_t) {
+	auto simu = make_arms(1);
+	simu->robot(0)->add_controller(std::make_shared<robox2d::control::MLPController>(mlp, 1.0, arm_observation));
+	return simu;
+      }, evaluator, 1, duration, nb_threads);
+
+    auto batch = std::make_shared<robox2d::control::BatchedMLP>(mlp, 1.0, arm_observation);
+    robox2d::SimuPool batched(nb_envs, [&](size_t) {
+	auto simu = make_arms(1);
+	batch->add_robots(*simu);
+	return simu;
+      }, evaluator, 1, duration, nb_threads);
+    batched.set_batch_controller(batch);
+
+    const double step = 0.2;
+    double t_single = bench::timeit([&]() { single.reset(nb_episodes); while (!single.done()) single.step(step); });
+    double t_batched = bench::timeit([&]() { batched.reset(nb_episodes); while (!batched.done()) batched.step(step); });
+    double max_error = (single.results() - batched.results()).cwiseAbs().maxCoeff();
+
+    double steps = nb_episodes * duration * 100; // physic steps at 100Hz
+    std::cout << "  " << nb_envs << " envs: per robot " << steps / t_single << " steps/s, batched " << steps / t_batched << " steps/s ("
+	      << t_single / t_batched << "x), max difference of the results " << max_error << std::endl;
+  }
+  return 0;
+}
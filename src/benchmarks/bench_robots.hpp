@@ -0,0 +1,216 @@
+#ifndef ROBOX2D_BENCHMARKS_BENCH_ROBOTS_HPP
+#define ROBOX2D_BENCHMARKS_BENCH_ROBOTS_HPP
+
+#include <chrono>
+
+#include <box2d/box2d.h>
+
+#include <robox2d/simu.hpp>
+#include <robox2d/robot.hpp>
+#include <robox2d/common.hpp>
+#include <robox2d/actuator.hpp>
+
+// Robots used by the benchmarks. They mirror the ones of src/examples/ (without any output in the control loop).
+namespace bench {
+
+  class Arm : public robox2d::Robot {
+  public:
+    
+    Arm(std::shared_ptr<b2World> world, size_t nb_joints = 8, const b2Vec2& origin = {0.0f, 0.0f}){
+
+      float arm_length=1.0;
+      float seg_length = arm_length / (float) nb_joints;
+    
+      b2Body* body = robox2d::common::createBox( world,{arm_length*0.025f, arm_length*0.025f}, b2_staticBody,  {origin.x,origin.y,0.0f} );
+      b2Vec2 anchor = body->GetWorldCenter();
+    
+      for(size_t i =0; i < nb_joints; i++)
+	{
+	  _end_effector = robox2d::common::createBox( world,{seg_length*0.5f , arm_length*0.01f }, b2_dynamicBody, {origin.x+(0.5f+i)*seg_length,origin.y,0.0f} );
+	  this->_actuators.push_back(std::make_shared<robox2d::actuator::Servo>(world,body, _end_effector, anchor));
+
+	  body=_end_effector;
+	  anchor = _end_effector->GetWorldCenter() + b2Vec2(seg_length*0.5 , 0.0f);
+	}
+
+      robox2d::common::createCircle( world,0.025f, b2_dynamicBody,  {origin.x+0.5f,origin.y+0.5f,0.0f} );
+    }
+
+    std::shared_ptr<robox2d::Robot> clone(robox2d::CloneMap& map) const override
+    {
+      auto arm = _clone_as<Arm>(map);
+      arm->_end_effector = map.body(_end_effector);
+      return arm;
+    }
+  
+    b2Vec2 get_end_effector_pos(){return _end_effector->GetWorldCenter(); }
+  
+  private:
+    b2Body* _end_effector;
+  };
+
+  inline Eigen::VectorXd arm_target(size_t nb_joints = 8)
+  {
+    Eigen::VectorXd ctrl_pos(nb_joints);
+    for(size_t i=0;i< (size_t)ctrl_pos.size();i++)
+      ctrl_pos[i]=0.5*M_PI/(1+(float) i);
+    return ctrl_pos;
+  }
+
+  /**
+   * @brief Build the simu of the arm_plain example.
+   */
+  inline std::shared_ptr<robox2d::Simu> make_arm_simu(size_t physic_freq = 100, size_t control_freq = 50, size_t graphic_freq = 50, size_t nb_joints = 8)
+  {
+    auto simu = std::make_shared<robox2d::Simu>(physic_freq, control_freq, graphic_freq);
+    simu->add_floor();
+    auto rob = std::make_shared<Arm>(simu->world(), nb_joints);
+    rob->add_controller(std::make_shared<robox2d::control::ConstantPos>(arm_target(nb_joints)));
+    simu->add_robot(rob);
+    return simu;
+  }
+
+  class Car : public robox2d::Robot {
+  public:
+  
+    Car(std::shared_ptr<b2World> world){
+
+      float hull_size = 0.1;
+   
+      _hull = robox2d::common::createBox( world,{hull_size*0.5f, hull_size}, b2_dynamicBody,  {0.0f,0.0f,0.0f} );
+    
+      for(size_t i =0; i < 2; i++)
+	{
+	  b2Vec2 anchor = _hull->GetWorldCenter() + (2*i-1.0)*b2Vec2({hull_size*0.75f,0});
+	
+	  b2Body* wheel = robox2d::common::createCircle( world, hull_size*0.25f, b2_dynamicBody, {anchor.x,anchor.y,0.0f} );
+	
+	  this->_actuators.push_back(std::make_shared<robox2d::actuator::WheelTraction>(wheel));
+	  robox2d::common::createWeldJoint( world, _hull, wheel, anchor);
+	}
+    }
+  
+    std::shared_ptr<robox2d::Robot> clone(robox2d::CloneMap& map) const override
+    {
+      auto copy = _clone_as<Car>(map);
+      copy->_hull = map.body(_hull);
+      return copy;
+    }
+
+    b2Vec2 get_hull_pos(){return _hull->GetWorldCenter(); }
+  
+  private:
+    b2Body* _hull;
+  };
+
+  inline std::shared_ptr<robox2d::Simu> make_car_simu(size_t physic_freq = 100, size_t control_freq = 50, size_t graphic_freq = 50)
+  {
+    auto simu = std::make_shared<robox2d::Simu>(physic_freq, control_freq, graphic_freq);
+    simu->add_floor();
+    Eigen::VectorXd ctrl_pos(2);
+    ctrl_pos[0]=0.5;
+    ctrl_pos[1]=0.25;
+    auto rob = std::make_shared<Car>(simu->world());
+    rob->add_controller(std::make_shared<robox2d::control::ConstantPos>(ctrl_pos));
+    simu->add_robot(rob);
+    return simu;
+  }
+
+  class LunarLander : public robox2d::Robot {
+  public:
+  
+    LunarLander(std::shared_ptr<b2World> world){
+
+      float hull_size = 0.1;
+   
+      _hull = robox2d::common::createBox( world,{hull_size, hull_size*0.75f}, b2_dynamicBody,  {0.0f,0.0f,0.0f}, 1.0f );
+      add_body(_hull);
+      robox2d::common::createBox( world,{10.0f, 0.5f}, b2_staticBody,  {0.0f,-1.0f,0.0f} );// ground
+    
+      const b2Vec2 offsets[4] = {{-0.8f, -1.0f}, {0.8f, -1.0f}, {-1.0f, 0.3f}, {1.0f, 0.3f}};
+      const b2Vec2 directions[4] = {{0, 1}, {0, 1}, {1, 0}, {-1, 0}};
+      for(size_t i =0; i < 4; i++)
+	{
+	  float radius =  hull_size*0.25f;
+	  b2Vec2 anchor = _hull->GetWorldCenter();
+	  if (i < 2)
+	    anchor += b2Vec2({offsets[i].x*hull_size, -(hull_size*0.75f+radius)});
+	  else
+	    anchor += b2Vec2({offsets[i].x*(hull_size+radius), offsets[i].y*hull_size});
+	
+	  robox2d::common::addBoxFixture( _hull, {radius*2.0f, radius*1.0f}, {anchor.x,anchor.y, 0.0f}, 0.0f); //REACTOR
+	  this->_actuators.push_back(std::make_shared<robox2d::actuator::PonctualForce>(_hull, anchor, directions[i])); 
+	}
+    }
+  
+    std::shared_ptr<robox2d::Robot> clone(robox2d::CloneMap& map) const override
+    {
+      auto copy = _clone_as<LunarLander>(map);
+      copy->_hull = map.body(_hull);
+      return copy;
+    }
+
+    b2Vec2 get_hull_pos(){return _hull->GetWorldCenter(); }
+  
+  private:
+    b2Body* _hull;
+  };
+
+  // Same as the LanderController of the lunar_lander example, without the output
+  class LanderController: public robox2d::control::BaseController {
+  public:
+    LanderController(): robox2d::control::BaseController(4){}
+      
+    void write_commands(double t, robox2d::Robot* robot, Eigen::Ref<Eigen::VectorXd> cmd){
+      // velocity of the hull: vx, vy and angular velocity
+      auto vel = robot->body_velocity(0);
+      cmd.setZero();
+
+      if(std::abs(vel[2])>0.001)
+	{
+	  if(vel[2] > 0)
+	    cmd[2]+= std::min(std::max(std::abs(vel[2])/50.0, 0.0), 0.01);
+	  else
+	    cmd[3]+= std::min(std::max(std::abs(vel[2])/50.0, 0.0), 0.01);
+	}
+	
+      if(vel[0] < 0)
+	cmd[2]+= std::min(std::max(std::abs(vel[0])/100.0, 0.0), 0.01);
+      else
+	cmd[3]+= std::min(std::max(std::abs(vel[0])/100.0, 0.0), 0.01);
+
+      if(vel.head<2>().norm()>0.001)
+	if(vel[1]<0)
+	  {
+	    cmd[0]= std::min(std::max(-vel[1]/400.0, 0.0), 0.02);
+	    cmd[1]= std::min(std::max(-vel[1]/200.0, 0.0), 0.02);
+	  }
+    }
+  };
+
+  inline std::shared_ptr<robox2d::Simu> make_lunar_lander_simu(size_t physic_freq = 100, size_t control_freq = 50, size_t graphic_freq = 50)
+  {
+    auto simu = std::make_shared<robox2d::Simu>(physic_freq, control_freq, graphic_freq);
+    simu->world()->SetGravity({0, -9.81});
+    simu->add_floor();
+    auto rob = std::make_shared<LunarLander>(simu->world());
+    rob->add_controller(std::make_shared<LanderController>());
+    simu->add_robot(rob);
+    return simu;
+  }
+
+  /**
+   * @brief Wall-clock time (in seconds) taken by f()
+   */
+  template <typename F>
+  double timeit(F&& f)
+  {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }
+  
+} // namespace bench
+
+#endif
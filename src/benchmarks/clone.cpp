@@ -0,0 +1,52 @@
+#include <iostream>
+#include <vector>
+
+#include <robox2d/thread_pool.hpp>
+
+#include "bench_robots.hpp"
+
+// Cost of Simu::clone (deep copy of the world and robots) against building the Arm simu from scratch,
+// and parallel rollouts spawned from a single template.
+
+int main()
+{
+  const size_t nb_copies = 10000;
+
+  double build_time = bench::timeit([&]() {
+    for (size_t i = 0; i < nb_copies; i++)
+      auto simu = bench::make_arm_simu();
+  });
+
+  auto templ = bench::make_arm_simu();
+  templ->run(1.0); // clone a mid-episode state
+  double clone_time = bench::timeit([&]() {
+    for (size_t i = 0; i < nb_copies; i++)
+      auto simu = templ->clone();
+  });
+
+  std::cout << "construct Arm: " << 1e6 * build_time / nb_copies << " us/simu" << std::endl;
+  std::cout << "clone Arm:     " << 1e6 * clone_time / nb_copies << " us/simu" << std::endl;
+
+  // rollouts from the template in worker threads
+  robox2d::ThreadPool pool;
+  const size_t nb_rollouts = 256;
+  std::vector<b2Vec2> end_effectors(nb_rollouts);
+  double rollout_time = bench::timeit([&]() {
+    pool.parallel_for(nb_rollouts, [&](size_t i) {
+      auto simu = templ->clone();
+      simu->run(2.0);
+      end_effectors[i] = std::static_pointer_cast<bench::Arm>(simu->robot(0))->get_end_effector_pos();
+    });
+  });
+
+  auto reference = templ->clone();
+  reference->run(2.0);
+  b2Vec2 ref = std::static_pointer_cast<bench::Arm>(reference->robot(0))->get_end_effector_pos();
+  size_t nb_identical = 0;
+  for (auto& p : end_effectors)
+    nb_identical += (p.x == ref.x && p.y == ref.y);
+
+  std::cout << nb_rollouts << " rollouts on " << pool.size() << " threads: " << rollout_time << "s, "
+	    << nb_identical << " identical to the sequential rollout" << std::endl;
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+
+#include <robox2d/gui/magnum/base_application.hpp>
+#include <robox2d/gui/instance_builder.hpp>
+
+#include "bench_robots.hpp"
+
+// Cost of building the instances of a frame (CPU only, no GL call): previous scene graph path (one Object2D and one
+// Drawable per fixture, transforms set in update_graphics, then Camera2D::draw) vs InstanceBuilder::build, without
+// culling and with culling on a 5x5 view (the bodies are spread on a 25x25 area).
+
+using namespace robox2d::gui;
+
+// The renderer before InstanceBuilder
+struct SceneGraphFrame {
+  SceneGraphFrame(const std::shared_ptr<b2World>& world) : world(world)
+  {
+    camera_object = new Object2D{&scene};
+    camera.reset(new Magnum::SceneGraph::Camera2D{*camera_object});
+    for (b2Body* body = world->GetBodyList(); body; body = body->GetNext())
+      for (b2Fixture* fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext()) {
+	auto obj = new Object2D{&scene};
+	objects.push_back(obj);
+	if (fixture->GetShape()->GetType() == b2Shape::e_circle) {
+	  float r = fixture->GetShape()->m_radius;
+	  obj->setScaling({r, r});
+	  new Drawable{*obj, circles, 0xeac9a5_rgbf, drawables};
+	}
+	else {
+	  auto v = static_cast<b2PolygonShape*>(fixture->GetShape())->m_vertices;
+	  obj->setScaling({(v[1] - v[0]).Length() / 2, (v[2] - v[1]).Length() / 2});
+	  new Drawable{*obj, boxes, 0xa5c9ea_rgbf, drawables};
+	}
+      }
+  }
+
+  void build()
+  {
+    size_t i = 0;
+    for (b2Body* body = world->GetBodyList(); body; body = body->GetNext())
+      for (b2Fixture* fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext(), i++) {
+	if (fixture->GetShape()->GetType() == b2Shape::e_circle) {
+	  auto pos = body->GetWorldPoint(static_cast<b2CircleShape*>(fixture->GetShape())->m_p);
+	  objects[i]->setTranslation({pos.x, pos.y});
+	}
+	else {
+	  auto v = static_cast<b2PolygonShape*>(fixture->GetShape())->m_vertices;
+	  auto pos = body->GetWorldPoint(0.5f * (v[2] + v[0]));
+	  objects[i]->setTranslation({pos.x, pos.y}).setRotation(Magnum::Complex::rotation(Magnum::Rad(body->GetAngle())));
+	}
+      }
+    arrayResize(boxes, 0);
+    arrayResize(circles, 0);
+    camera->draw(drawables);
+  }
+
+  std::shared_ptr<b2World> world;
+  Scene2D scene;
+  Object2D* camera_object;
+  std::unique_ptr<Magnum::SceneGraph::Camera2D> camera;
+  Magnum::SceneGraph::DrawableGroup2D drawables;
+  std::vector<Object2D*> objects;
+  Magnum::Containers::Array<InstanceData> boxes, circles;
+};
+
+int main()
+{
+  const size_t nb_frames = 200;
+  for (size_t nb_bodies : {100, 1000, 10000}) {
+    auto world = std::make_shared<b2World>(b2Vec2(0.0f, 0.0f));
+    for (size_t i = 0; i < nb_bodies; i++) {
+      b2Vec3 pose = {0.25f * (i % 100), 0.25f * (i / 100), 0.1f * i};
+      if (i % 2)
+	robox2d::common::createBox(world, {0.1f, 0.05f}, b2_dynamicBody, pose);
+      else
+	robox2d::common::createCircle(world, 0.1f, b2_dynamicBody, pose);
+    }
+
+    SceneGraphFrame scene_graph(world);
+    InstanceBuilder builder(world);
+    builder.set_culling(false);
+    double t_scene_graph = bench::timeit([&]() {
+      for (size_t i = 0; i < nb_frames; i++)
+	scene_graph.build();
+    });
+    double t_builder = bench::timeit([&]() {
+      for (size_t i = 0; i < nb_frames; i++)
+	builder.build();
+    });
+    builder.set_culling(true);
+    builder.set_view({12.5f, 12.5f}, {2.5f, 2.5f});
+    double t_culled = bench::timeit([&]() {
+      for (size_t i = 0; i < nb_frames; i++)
+	builder.build();
+    });
+    std::cout << nb_bodies << " bodies: scene graph " << 1e6 * t_scene_graph / nb_frames << " us/frame, instance builder "
+	      << 1e6 * t_builder / nb_frames << " us/frame (" << t_scene_graph / t_builder << "x), with culling "
+	      << 1e6 * t_culled / nb_frames << " us/frame (" << builder.instances(InstanceBuilder::Box).size() + builder.instances(InstanceBuilder::Circle).size()
+	      << " visible)" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,49 @@
+#include <iostream>
+#include <random>
+
+#include <robox2d/sensor.hpp>
+
+#include "bench_robots.hpp"
+
+// Frames per second (one core) of the CPU grid sensors: egocentric occupancy grids and RGB top-down images of
+// several sizes, in a world with 400 obstacles.
+
+int main()
+{
+  auto simu = std::make_shared<robox2d::Simu>(100, 50, 50);
+  auto world = simu->world();
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> pos(-20.0f, 20.0f), size(0.1f, 0.5f);
+  for (size_t i = 0; i < 400; i++) {
+    if (i % 2)
+      robox2d::common::createBox(world, {size(gen), size(gen)}, b2_staticBody, {pos(gen), pos(gen), pos(gen)});
+    else
+      robox2d::common::createCircle(world, size(gen), b2_staticBody, {pos(gen), pos(gen), 0.0f});
+  }
+  std::vector<b2Body*> bodies;
+  for (size_t i = 0; i < 16; i++)
+    bodies.push_back(robox2d::common::createCircle(world, 0.1f, b2_dynamicBody, {pos(gen), pos(gen), pos(gen)}));
+
+  const size_t nb_frames = 20000;
+  for (size_t grid_size : {16, 32, 64, 128}) {
+    const float resolution = grid_size / 4.0f; // 4 m x 4 m around the robot
+    for (size_t channels : {1, 3}) {
+      std::vector<std::shared_ptr<robox2d::sensor::GridSensor>> sensors;
+      for (b2Body* body : bodies)
+	sensors.push_back(std::make_shared<robox2d::sensor::GridSensor>(body, grid_size, grid_size, resolution, channels));
+      std::vector<double> obs(sensors[0]->size());
+
+      size_t nb_drawn = 0;
+      double t = bench::timeit([&]() {
+	for (size_t i = 0; i < nb_frames; i++) {
+	  auto& sensor = sensors[i % sensors.size()];
+	  sensor->update(obs.data());
+	  nb_drawn += sensor->rasterizer().nb_drawn();
+	}
+      });
+      std::cout << grid_size << "x" << grid_size << (channels == 1 ? " occupancy: " : " RGB:       ") << nb_frames / t << " frames/s ("
+		<< double(nb_drawn) / nb_frames << " fixtures/frame)" << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <thread>
+
+#include "bench_robots.hpp"
+
+// Overhead of the per-step state hash, and determinism check: clones of the same simu stepped in parallel threads
+// must produce identical hash streams (and a perturbed one must be reported at the perturbed tick).
+
+namespace {
+  std::shared_ptr<robox2d::Simu> make_arms_simu(size_t nb_arms)
+  {
+    auto simu = std::make_shared<robox2d::Simu>(100, 50, 50);
+    simu->add_floor();
+    for (size_t i = 0; i < nb_arms; i++) {
+      auto rob = std::make_shared<bench::Arm>(simu->world(), 8, b2Vec2(3.0f * i, 0.0f));
+      rob->add_controller(std::make_shared<robox2d::control::ConstantPos>(bench::arm_target(8)));
+      simu->add_robot(rob);
+    }
+    return simu;
+  }
+}
+
+int main()
+{
+  const size_t nb_arms = 32;
+  const double duration = 20.0;
+
+  auto plain = make_arms_simu(nb_arms);
+  double t_plain = bench::timeit([&]() { plain->run(duration); });
+  auto hashed = make_arms_simu(nb_arms);
+  hashed->enable_state_hash();
+  double t_hashed = bench::timeit([&]() { hashed->run(duration); });
+  size_t nb_steps = hashed->state_hashes().size();
+
+  // same initial state in 4 threads
+  auto reference = make_arms_simu(nb_arms);
+  reference->enable_state_hash();
+  std::vector<std::shared_ptr<robox2d::Simu>> clones;
+  for (size_t i = 0; i < 4; i++)
+    clones.push_back(reference->clone());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < clones.size(); i++)
+    threads.emplace_back([&clones, i, duration]() {
+      if (i == clones.size() - 1) { // the last one gets a perturbation
+	clones[i]->run(duration / 2);
+	b2Body* body = clones[i]->world()->GetBodyList();
+	body->SetAngularVelocity(body->GetAngularVelocity() + 1e-6f);
+	clones[i]->run(duration / 2);
+      }
+      else
+	clones[i]->run(duration);
+    });
+  for (auto& t : threads)
+    t.join();
+
+  std::cout << nb_arms << " arms: " << 1e6 * t_plain / nb_steps << " us/step without hash, " << 1e6 * t_hashed / nb_steps
+	    << " us/step with hash (+" << 100.0 * (t_hashed - t_plain) / t_plain << "%)" << std::endl;
+  // the unperturbed threads must be identical, the perturbed one must diverge (the run fails otherwise)
+  bool ok = true;
+  for (size_t i = 1; i < clones.size(); i++) {
+    size_t tick = robox2d::first_divergence(clones[0]->state_hashes(), clones[i]->state_hashes());
+    std::cout << "thread " << i << " vs thread 0: ";
+    if (tick == robox2d::no_divergence)
+      std::cout << "identical (" << clones[i]->state_hashes().size() << " hashes)" << std::endl;
+    else
+      std::cout << "diverged at tick " << tick << " (" << tick / double(clones[i]->tick_freq()) << " s)" << std::endl;
+    const bool perturbed = i == clones.size() - 1;
+    ok = ok && (tick == robox2d::no_divergence) != perturbed;
+  }
+  return ok ? 0 : 1;
+}
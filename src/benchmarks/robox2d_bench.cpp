@@ -0,0 +1,419 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <robox2d/descriptor/base_descriptor.hpp>
+#include <robox2d/gui/instance_builder.hpp>
+
+#include "bench_robots.hpp"
+
+#ifdef GRAPHIC
+#include <robox2d/gui/magnum/graphics.hpp>
+#include <robox2d/gui/magnum/threaded_graphics.hpp>
+#endif
+
+// Benchmark suite of robox2d.
+//
+//   robox2d_bench [--filter name] [--repeat N] [--json results.json] [--baseline baseline.json] [--tolerance 0.1]
+//
+// Each benchmark is run N times (after a warm-up run) and the median is reported. With --baseline, the results
+// are compared with a previous --json output and the program exits with 1 if a metric regressed by more than
+// the tolerance (relative) or is missing. It also exits with 1 if a loop allocates (*_allocs_per_step above 0).
+// Without --json, the JSON is written to stdout; the progress and the comparison report always go to stderr.
+
+// Count the heap allocations of the program (for the allocs_per_step metrics). Eigen allocates with std::malloc,
+// not operator new: with glibc, malloc itself is interposed so both are counted.
+static std::atomic<size_t> nb_allocations(0);
+
+#if defined(__GLIBC__)
+extern "C" {
+  void* __libc_malloc(std::size_t size);
+  void* __libc_calloc(std::size_t nb, std::size_t size);
+  void* __libc_realloc(void* p, std::size_t size);
+
+  void* malloc(std::size_t size)
+  {
+    nb_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+  }
+
+  void* calloc(std::size_t nb, std::size_t size)
+  {
+    nb_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(nb, size);
+  }
+
+  void* realloc(void* p, std::size_t size)
+  {
+    nb_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+  }
+}
+#else
+// elsewhere, only operator new is seen (the allocations of Eigen are missed)
+void* operator new(std::size_t size)
+{
+  nb_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
+
+struct Metric {
+  std::string name;
+  double value;
+  std::string unit;
+  bool higher_is_better;
+};
+
+struct Benchmark {
+  std::string name;
+  std::string unit;
+  bool higher_is_better;
+  std::function<double()> run; // one measurement
+};
+
+// Descriptor doing a typical amount of work: reading the state of every body
+struct BodyDescriptor : public robox2d::descriptor::BaseDescriptor {
+  BodyDescriptor(size_t desc_dump = 1) : robox2d::descriptor::BaseDescriptor(desc_dump) {}
+  void operator()() override
+  {
+    for (b2Body* body = _simu->world()->GetBodyList(); body; body = body->GetNext())
+      sum += body->GetPosition().x + body->GetPosition().y;
+  }
+  double sum = 0;
+};
+
+// Same work, reading the world state shared by the consumers of the simu (gathered once per step)
+struct StateDescriptor : public robox2d::descriptor::BaseDescriptor {
+  StateDescriptor(size_t desc_dump = 1) : robox2d::descriptor::BaseDescriptor(desc_dump) {}
+  void operator()() override
+  {
+    const robox2d::WorldState& ws = _simu->world_state();
+    for (size_t i = 0; i < ws.size(); i++)
+      sum += ws.x[i] + ws.y[i];
+  }
+  double sum = 0;
+};
+
+double steps_per_second(const std::shared_ptr<robox2d::Simu>& simu, double duration)
+{
+  double t = bench::timeit([&]() { simu->run(duration); });
+  return duration / simu->physic_period() / t;
+}
+
+// Heap allocations per physic step once the simu is in steady state (must be 0)
+double allocations_per_step(const std::shared_ptr<robox2d::Simu>& simu)
+{
+  simu->run(5.0); // let the contacts and the Box2D allocators settle
+  size_t before = nb_allocations;
+  simu->run(5.0);
+  return (nb_allocations - before) / (5.0 / simu->physic_period());
+}
+
+std::vector<Benchmark> benchmarks()
+{
+  std::vector<Benchmark> b;
+
+  // macro benchmarks: the plain examples
+  b.push_back({"arm_plain", "steps/s", true, []() { return steps_per_second(bench::make_arm_simu(), 20.0); }});
+  b.push_back({"car_plain", "steps/s", true, []() { return steps_per_second(bench::make_car_simu(), 20.0); }});
+  b.push_back({"lunar_lander_plain", "steps/s", true, []() { return steps_per_second(bench::make_lunar_lander_simu(), 20.0); }});
+
+  // the control and physic loops should not allocate
+  b.push_back({"arm_allocs_per_step", "allocs/step", false, []() { return allocations_per_step(bench::make_arm_simu()); }});
+  b.push_back({"car_allocs_per_step", "allocs/step", false, []() { return allocations_per_step(bench::make_car_simu()); }});
+  b.push_back({"lunar_lander_allocs_per_step", "allocs/step", false, []() { return allocations_per_step(bench::make_lunar_lander_simu()); }});
+
+  // scaling with the number of robots in the same world
+  for (size_t nb_robots : {1, 4, 16, 64}) {
+    b.push_back({"arm_robots_" + std::to_string(nb_robots), "steps/s", true, [nb_robots]() {
+      auto simu = std::make_shared<robox2d::Simu>();
+      simu->add_floor();
+      for (size_t i = 0; i < nb_robots; i++) {
+	auto rob = std::make_shared<bench::Arm>(simu->world(), 8, b2Vec2(3.0f * i, 0.0f));
+	rob->add_controller(std::make_shared<robox2d::control::ConstantPos>(bench::arm_target()));
+	simu->add_robot(rob);
+      }
+      return steps_per_second(simu, 5.0);
+    }});
+  }
+
+  // scaling with the number of bodies (boxes falling in a pile)
+  for (size_t nb_bodies : {10, 100, 1000}) {
+    b.push_back({"bodies_" + std::to_string(nb_bodies), "steps/s", true, [nb_bodies]() {
+      auto simu = std::make_shared<robox2d::Simu>();
+      simu->world()->SetGravity({0, -9.81});
+      simu->add_floor();
+      for (size_t i = 0; i < nb_bodies; i++)
+	robox2d::common::createBox(simu->world(), {0.1f, 0.1f}, b2_dynamicBody, {-5.0f + 0.25f * (i % 40), -9.5f + 0.25f * (i / 40), 0.0f});
+      return steps_per_second(simu, 5.0);
+    }});
+  }
+
+  // cost of one actuator update (servos of a 64-joint arm)
+  b.push_back({"servo_update", "ns/actuator", false, []() {
+    auto simu = bench::make_arm_simu(100, 50, 50, 64);
+    auto robot = simu->robot(0);
+    robot->control_update(0.0);
+    const size_t nb_updates = 10000;
+    double t = bench::timeit([&]() {
+      for (size_t i = 0; i < nb_updates; i++)
+	robot->physic_update();
+    });
+    return 1e9 * t / (nb_updates * robot->nb_dofs());
+  }});
+
+  // reading the joint state of a 64-joint arm 4 times per step (one refresh, then cached views)
+  b.push_back({"state_access", "ns/joint", false, []() {
+    auto simu = bench::make_arm_simu(100, 50, 50, 64);
+    auto robot = simu->robot(0);
+    const size_t nb_steps = 10000;
+    volatile double sum = 0; // keeps the reads
+    double t = bench::timeit([&]() {
+      for (size_t i = 0; i < nb_steps; i++) {
+	robot->invalidate_state();
+	for (size_t k = 0; k < 4; k++)
+	  sum += robot->positions().sum() + robot->velocities().sum();
+      }
+    });
+    return 1e9 * t / (nb_steps * robot->nb_joints());
+  }});
+
+  // overhead of descriptors dumped at every physic step, reading the bodies and the shared world state
+  for (bool shared : {false, true}) {
+    b.push_back({shared ? "descriptor_overhead_world_state" : "descriptor_overhead", "ratio", false, [shared]() {
+      auto plain = bench::make_arm_simu();
+      double t_plain = bench::timeit([&]() { plain->run(20.0); });
+      auto simu = bench::make_arm_simu();
+      for (size_t i = 0; i < 4; i++) {
+	if (shared)
+	  simu->add_descriptor<StateDescriptor>(1);
+	else
+	  simu->add_descriptor<BodyDescriptor>(1);
+      }
+      double t_desc = bench::timeit([&]() { simu->run(20.0); });
+      return t_desc / t_plain;
+    }});
+  }
+
+  // accuracy of the real-time pacing (relative error on the real-time factor, 2s of simulated time at 2x)
+  b.push_back({"pacing_error", "ratio", false, []() {
+    auto simu = bench::make_arm_simu();
+    simu->set_sync(true);
+    simu->set_real_time_factor(2.0);
+    simu->run(2.0);
+    return std::abs(simu->pacing_stats().achieved_rtf() / 2.0 - 1.0);
+  }});
+
+  // CPU cost of the instances of a frame (renderer, no GL call), for the whole world and with culling on a 5x5 view
+  for (bool culling : {false, true}) {
+    b.push_back({culling ? "frame_build_10000_culled" : "frame_build_10000", "us/frame", false, [culling]() {
+      auto world = std::make_shared<b2World>(b2Vec2(0.0f, 0.0f));
+      for (size_t i = 0; i < 10000; i++)
+	robox2d::common::createBox(world, {0.1f, 0.05f}, b2_dynamicBody, {0.25f * (i % 100), 0.25f * (i / 100), 0.1f * i});
+      robox2d::gui::InstanceBuilder builder(world);
+      builder.set_culling(culling);
+      builder.set_view({12.5f, 12.5f}, {2.5f, 2.5f});
+      const size_t nb_frames = 200;
+      double t = bench::timeit([&]() {
+	for (size_t i = 0; i < nb_frames; i++)
+	  builder.build();
+      });
+      return 1e6 * t / nb_frames;
+    }});
+  }
+
+  // same frame from the world state, gathered again for each frame (as after a physic step)
+  b.push_back({"frame_build_10000_world_state", "us/frame", false, []() {
+    auto world = std::make_shared<b2World>(b2Vec2(0.0f, 0.0f));
+    for (size_t i = 0; i < 10000; i++)
+      robox2d::common::createBox(world, {0.1f, 0.05f}, b2_dynamicBody, {0.25f * (i % 100), 0.25f * (i / 100), 0.1f * i});
+    robox2d::WorldStateCache cache(world.get());
+    robox2d::gui::InstanceBuilder builder(world);
+    builder.set_culling(false);
+    builder.set_state_cache(&cache);
+    const size_t nb_frames = 200;
+    double t = bench::timeit([&]() {
+      for (size_t i = 0; i < nb_frames; i++) {
+	cache.invalidate();
+	builder.build();
+      }
+    });
+    return 1e6 * t / nb_frames;
+  }});
+
+#ifdef GRAPHIC
+  // headless rendering with the frames captured (synchronous readback, then ring of 3 pixel buffers)
+  for (size_t ring : {0, 3}) {
+    b.push_back({ring ? "windowless_render_async" : "windowless_render", "frames/s", true, [ring]() {
+      get_gl_context_robox2d(gl_context);
+      double fps = 0;
+      {
+	auto simu = bench::make_arm_simu();
+	auto graphics = std::make_shared<robox2d::gui::Graphics<robox2d::gui::magnum::WindowlessGLApplication>>(simu.get());
+	auto app = static_cast<robox2d::gui::magnum::WindowlessGLApplication*>(graphics->magnum_app());
+	app->set_readback_ring(ring);
+	simu->set_graphics(graphics);
+	const size_t nb_frames = 500;
+	double t = bench::timeit([&]() {
+	  for (size_t i = 0; i < nb_frames; i++) {
+	    graphics->refresh();
+	    app->latest_image(); // a capture loop would encode this image
+	  }
+	  app->image(); // wait for the frames in flight
+	});
+	fps = nb_frames / t;
+      }
+      release_gl_context_robox2d(gl_context);
+      return fps;
+    }});
+  }
+
+  // simulation speed with headless graphics rendered inline and in their own thread
+  b.push_back({"arm_windowless_inline", "steps/s", true, []() {
+    get_gl_context_robox2d(gl_context);
+    double steps = 0;
+    {
+      auto simu = bench::make_arm_simu();
+      simu->set_graphics(std::make_shared<robox2d::gui::Graphics<robox2d::gui::magnum::WindowlessGLApplication>>(simu.get()));
+      steps = steps_per_second(simu, 10.0);
+    }
+    release_gl_context_robox2d(gl_context);
+    return steps;
+  }});
+  b.push_back({"arm_windowless_threaded", "steps/s", true, []() {
+    auto simu = bench::make_arm_simu();
+    simu->set_graphics(std::make_shared<robox2d::gui::ThreadedGraphics<robox2d::gui::magnum::WindowlessGLApplication>>(simu.get()));
+    return steps_per_second(simu, 10.0);
+  }});
+#endif
+
+  return b;
+}
+
+double median(std::vector<double> values)
+{
+  std::sort(values.begin(), values.end());
+  size_t n = values.size();
+  return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+void write_json(std::ostream& os, const std::vector<Metric>& metrics)
+{
+  os << "{\n  \"benchmarks\": [\n";
+  for (size_t i = 0; i < metrics.size(); i++) {
+    const Metric& m = metrics[i];
+    os << "    {\"name\": \"" << m.name << "\", \"value\": " << m.value << ", \"unit\": \"" << m.unit
+       << "\", \"higher_is_better\": " << (m.higher_is_better ? "true" : "false") << "}" << (i + 1 < metrics.size() ? "," : "") << "\n";
+  }
+  os << "  ]\n}\n";
+}
+
+// Returns the number of regressions (metrics of the baseline missing from this run count as regressions). The report
+// goes to stderr: stdout only has the JSON when there is no --json file.
+size_t compare(const std::vector<Metric>& metrics, const std::string& baseline_file, double tolerance, const std::string& filter)
+{
+  boost::property_tree::ptree baseline;
+  boost::property_tree::read_json(baseline_file, baseline);
+
+  size_t nb_regressions = 0;
+  for (const auto& entry : baseline.get_child("benchmarks")) {
+    const auto& b = entry.second;
+    std::string name = b.get<std::string>("name");
+    double reference = b.get<double>("value");
+    auto m = std::find_if(metrics.begin(), metrics.end(), [&](const Metric& m) { return m.name == name; });
+    if (m == metrics.end()) {
+      // filtered out on purpose, or removed/renamed
+      if (!filter.empty() && name.find(filter) == std::string::npos)
+	continue;
+      nb_regressions++;
+      std::cerr << "MISSING    " << name << ": in the baseline but not measured" << std::endl;
+      continue;
+    }
+
+    // a zero baseline (e.g. allocations) does not tolerate any increase
+    double change = reference != 0.0 ? (m->value - reference) / reference : (m->value > 0.0 ? 1.0 : 0.0);
+    bool regression = m->higher_is_better ? change < -tolerance : (reference != 0.0 ? change > tolerance : m->value > 0.0);
+    nb_regressions += regression;
+    std::cerr << (regression ? "REGRESSION " : "ok         ") << name << ": " << reference << " -> " << m->value << " " << m->unit
+	      << " (" << (change > 0 ? "+" : "") << 100.0 * change << "%)" << std::endl;
+  }
+  return nb_regressions;
+}
+
+int main(int argc, char** argv)
+{
+  std::string filter, json_file, baseline_file;
+  size_t repeat = 5;
+  double tolerance = 0.1;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value for " << arg << std::endl;
+      return 2;
+    }
+    if (arg == "--filter")
+      filter = argv[++i];
+    else if (arg == "--repeat")
+      repeat = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--json")
+      json_file = argv[++i];
+    else if (arg == "--baseline")
+      baseline_file = argv[++i];
+    else if (arg == "--tolerance")
+      tolerance = std::atof(argv[++i]);
+    else {
+      std::cerr << "Unknown option " << arg << std::endl;
+      return 2;
+    }
+  }
+
+  std::vector<Metric> metrics;
+  for (auto& b : benchmarks()) {
+    if (!filter.empty() && b.name.find(filter) == std::string::npos)
+      continue;
+    b.run(); // warm-up
+    std::vector<double> values;
+    for (size_t i = 0; i < repeat; i++)
+      values.push_back(b.run());
+    metrics.push_back({b.name, median(values), b.unit, b.higher_is_better});
+    std::cerr << b.name << ": " << metrics.back().value << " " << b.unit << std::endl;
+  }
+
+  if (json_file.empty())
+    write_json(std::cout, metrics);
+  else {
+    std::ofstream ofs(json_file);
+    write_json(ofs, metrics);
+  }
+
+  // the control and physic loops must not allocate, whatever the baseline
+  bool failed = false;
+  const std::string allocs = "_allocs_per_step";
+  for (auto& m : metrics) {
+    if (m.name.size() > allocs.size() && m.name.compare(m.name.size() - allocs.size(), allocs.size(), allocs) == 0 && m.value > 0.0) {
+      std::cerr << "FAILED     " << m.name << ": " << m.value << " " << m.unit << " (must be 0)" << std::endl;
+      failed = true;
+    }
+  }
+
+  if (!baseline_file.empty() && compare(metrics, baseline_file, tolerance, filter) > 0)
+    failed = true;
+  return failed ? 1 : 0;
+}
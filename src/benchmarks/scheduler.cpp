@@ -0,0 +1,62 @@
+#include <iostream>
+#include <cmath>
+
+#include "bench_robots.hpp"
+
+// Compares the integer-tick scheduler of Simu::run with the previous
+// `std::remainder`-based loop, which visited every tick of the lcm of the frequencies.
+
+// Previous implementation of Simu::run, rewritten on top of the public API.
+// The physic step uses the physic period so that both loops do the same amount of physics per simulated second.
+size_t legacy_run(robox2d::Simu& simu, double max_duration, size_t physic_freq, size_t control_freq, size_t graphic_freq)
+{
+  double time_step = 1.0 / double(simu.tick_freq());
+  double physic_period = 1.0 / (double)physic_freq;
+  double control_period = 1.0 / (double)control_freq;
+  double graphic_period = 1.0 / (double)graphic_freq;
+  double time = 0;
+  size_t nb_physic_steps = 0;
+  size_t nb_graphic_steps = 0;
+
+  while ((time - max_duration) < -time_step / 2.0) {
+    time += time_step;
+    if (std::abs(std::remainder(time, control_period)) < 1e-4)
+      for (auto& robot : simu.robots())
+	robot->control_update(time);
+
+    if (std::abs(std::remainder(time, physic_period)) < 1e-4) {
+      for (auto& robot : simu.robots())
+	robot->physic_update();
+      simu.world()->Step(physic_period, 6, 2);
+      nb_physic_steps++;
+    }
+
+    if (std::abs(std::remainder(time, graphic_period)) < 1e-4)
+      nb_graphic_steps++; // no graphics attached: only the check is paid
+  }
+  return nb_physic_steps;
+}
+
+void bench_frequencies(size_t physic_freq, size_t control_freq, size_t graphic_freq, double duration)
+{
+  auto legacy_simu = bench::make_arm_simu(physic_freq, control_freq, graphic_freq);
+  size_t legacy_steps = 0;
+  double legacy_time = bench::timeit([&]() { legacy_steps = legacy_run(*legacy_simu, duration, physic_freq, control_freq, graphic_freq); });
+
+  auto simu = bench::make_arm_simu(physic_freq, control_freq, graphic_freq);
+  double tick_time = bench::timeit([&]() { simu->run(duration); });
+  size_t tick_steps = std::llround(duration * physic_freq);
+
+  std::cout << physic_freq << "/" << control_freq << "/" << graphic_freq << " Hz (lcm: " << simu->tick_freq() << " ticks/s)" << std::endl;
+  std::cout << "  remainder loop: " << legacy_steps << " physic steps, " << legacy_steps / legacy_time << " steps/s" << std::endl;
+  std::cout << "  tick scheduler: " << tick_steps << " physic steps, " << tick_steps / tick_time << " steps/s" << std::endl;
+  std::cout << "  speed-up: " << (legacy_time / legacy_steps) / (tick_time / tick_steps) << "x" << std::endl;
+}
+
+int main()
+{
+  bench_frequencies(100, 50, 50, 100.0);
+  bench_frequencies(1000, 500, 50, 20.0);
+  bench_frequencies(1000, 333, 60, 20.0);
+  return 0;
+}
@@ -0,0 +1,90 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include <robox2d/sensor.hpp>
+
+#include "bench_robots.hpp"
+
+// Cost of the lidars of many robots: batched ray casts (one broadphase query per robot, see sensor::RayBatch)
+// vs one b2World::RayCast per ray, for 1 to 1000 rays per robot and 1 to 100 robots in a world with obstacles.
+
+namespace {
+  struct ClosestHit : public b2RayCastCallback {
+    float ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction) override
+    {
+      if (fixture->GetBody() == ignore || fixture->IsSensor())
+	return -1.0f;
+      closest = fraction;
+      return fraction;
+    }
+
+    b2Body* ignore = nullptr;
+    float closest = 1.0f;
+  };
+
+  std::shared_ptr<robox2d::Simu> make_world(size_t nb_robots, size_t nb_rays, float max_range)
+  {
+    auto simu = std::make_shared<robox2d::Simu>(100, 50, 50);
+    auto world = simu->world();
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<float> pos(-20.0f, 20.0f), size(0.1f, 0.5f);
+    for (size_t i = 0; i < 400; i++) {
+      if (i % 2)
+	robox2d::common::createBox(world, {size(gen), size(gen)}, b2_staticBody, {pos(gen), pos(gen), pos(gen)});
+      else
+	robox2d::common::createCircle(world, size(gen), b2_staticBody, {pos(gen), pos(gen), 0.0f});
+    }
+    for (size_t i = 0; i < nb_robots; i++) {
+      auto robot = std::make_shared<robox2d::Robot>();
+      b2Body* body = robox2d::common::createCircle(world, 0.1f, b2_dynamicBody, {pos(gen), pos(gen), 0.0f});
+      robot->add_sensor(std::make_shared<robox2d::sensor::Lidar>(body, b2Vec2(0.0f, 0.0f), nb_rays, 2.0f * b2_pi, max_range));
+      simu->add_robot(robot);
+    }
+    return simu;
+  }
+}
+
+int main()
+{
+  const float max_range = 5.0f;
+  bool ok = true;
+  for (size_t nb_robots : {1, 10, 100}) {
+    for (size_t nb_rays : {1, 10, 100, 1000}) {
+      auto simu = make_world(nb_robots, nb_rays, max_range);
+      const size_t nb_updates = std::max<size_t>(1, 100000 / (nb_robots * nb_rays));
+
+      double t_batch = bench::timeit([&]() {
+	for (size_t k = 0; k < nb_updates; k++)
+	  for (auto& robot : simu->robots())
+	    robot->sensor_update();
+      });
+
+      double max_error = 0.0;
+      ClosestHit callback;
+      double t_naive = bench::timeit([&]() {
+	for (size_t k = 0; k < nb_updates; k++)
+	  for (auto& robot : simu->robots()) {
+	    auto lidar = std::static_pointer_cast<robox2d::sensor::Lidar>(robot->sensors()[0]);
+	    const b2Transform& xf = lidar->body()->GetTransform();
+	    callback.ignore = lidar->body();
+	    for (size_t r = 0; r < nb_rays; r++) {
+	      b2Vec2 p1 = b2Mul(xf, lidar->anchor());
+	      b2Vec2 p2 = p1 + max_range * b2Mul(xf.q, lidar->directions()[r]);
+	      callback.closest = 1.0f;
+	      simu->world()->RayCast(&callback, p1, p2);
+	      if (k == 0)
+		max_error = std::max(max_error, std::abs(callback.closest * max_range - robot->observations()[r]));
+	    }
+	  }
+      });
+
+      double nb_casts = double(nb_updates) * nb_robots * nb_rays;
+      std::cout << nb_robots << " robots x " << nb_rays << " rays: batched " << 1e9 * t_batch / nb_casts << " ns/ray, "
+		<< "b2World::RayCast " << 1e9 * t_naive / nb_casts << " ns/ray (max difference " << max_error << ")" << std::endl;
+      ok = ok && max_error < 1e-4;
+    }
+  }
+  // the batched measures must match b2World::RayCast (the run fails otherwise)
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <robox2d/simu_pool.hpp>
+
+#include "bench_robots.hpp"
+
+// Scaling of SimuPool from 1 thread to all the cores, on the three examples.
+
+void bench_scaling(const std::string& name, const robox2d::SimuPool::factory_t& factory, size_t nb_episodes, double duration)
+{
+  // the result of an episode is the simulated time (only the throughput matters here)
+  auto evaluator = [](robox2d::Simu& simu, size_t, double* result) { result[0] = simu.time(); };
+
+  size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  double reference = 0;
+  std::cout << name << " (" << nb_episodes << " episodes of " << duration << "s)" << std::endl;
+  for (size_t nb_threads = 1; nb_threads <= max_threads; nb_threads = (nb_threads == max_threads) ? nb_threads + 1 : std::min(2 * nb_threads, max_threads)) {
+    robox2d::SimuPool pool(2 * nb_threads, factory, evaluator, 1, duration, nb_threads);
+
+    double async_time = bench::timeit([&]() { pool.reset(nb_episodes); pool.run(); });
+    double lockstep_time = bench::timeit([&]() { pool.reset(nb_episodes); while (!pool.done()) pool.step(duration / 10.0); });
+
+    if (nb_threads == 1)
+      reference = async_time;
+    double steps = nb_episodes * duration * 100; // physic steps at 100Hz
+    std::cout << "  " << nb_threads << " threads: async " << steps / async_time << " steps/s (speed-up " << reference / async_time << "x)"
+	      << ", lockstep " << steps / lockstep_time << " steps/s" << std::endl;
+  }
+}
+
+int main()
+{
+  bench_scaling("arm", [](size_t) { return bench::make_arm_simu(); }, 256, 5.0);
+  bench_scaling("car", [](size_t) { return bench::make_car_simu(); }, 256, 5.0);
+  bench_scaling("lunar_lander", [](size_t) { return bench::make_lunar_lander_simu(); }, 256, 5.0);
+  return 0;
+}
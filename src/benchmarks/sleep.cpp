@@ -0,0 +1,34 @@
+#include <iostream>
+
+#include "bench_robots.hpp"
+
+// Cost of the simulation once arms have reached their ConstantPos target. With a negative or null tolerance the
+// servos set their motor speed at every step, which wakes the joints up whenever the speed changes (previous
+// behaviour); with a positive tolerance (rad/s), they keep their speed once close to the target and the arms sleep.
+
+int main()
+{
+  const size_t nb_arms = 32;
+  for (double tolerance : {-1.0, 0.0, 1e-3}) {
+    auto simu = std::make_shared<robox2d::Simu>(100, 50, 50);
+    simu->add_floor();
+    for (size_t i = 0; i < nb_arms; i++) {
+      auto rob = std::make_shared<bench::Arm>(simu->world(), 8, b2Vec2(3.0f * i, 0.0f));
+      rob->add_controller(std::make_shared<robox2d::control::ConstantPos>(bench::arm_target(8)));
+      rob->set_actuator_tolerance(tolerance);
+      simu->add_robot(rob);
+    }
+    double t_reach = bench::timeit([&]() { simu->run(10.0); }); // reach the target and fall asleep
+    double t_hold = bench::timeit([&]() { simu->run(10.0); });
+
+    size_t awake = 0, nb_bodies = 0;
+    for (b2Body* b = simu->world()->GetBodyList(); b; b = b->GetNext())
+      if (b->GetType() != b2_staticBody) {
+	nb_bodies++;
+	awake += b->IsAwake();
+      }
+    std::cout << "tolerance " << tolerance << ": reach " << 1e6 * t_reach / 1000 << " us/step, hold "
+	      << 1e6 * t_hold / 1000 << " us/step, " << awake << "/" << nb_bodies << " bodies awake" << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,40 @@
+#include <iostream>
+
+#include "bench_robots.hpp"
+
+// Cost of an episode reset: rebuilding the simu from scratch vs restoring a snapshot in place.
+
+int main()
+{
+  const size_t nb_resets = 10000;
+
+  double rebuild_time = bench::timeit([&]() {
+    for (size_t i = 0; i < nb_resets; i++)
+      auto simu = bench::make_arm_simu();
+  });
+
+  auto simu = bench::make_arm_simu();
+  robox2d::Snapshot initial = simu->snapshot();
+  simu->run(1.0);
+
+  double restore_time = bench::timeit([&]() {
+    for (size_t i = 0; i < nb_resets; i++)
+      simu->restore(initial);
+  });
+
+  // branching: restore a mid-episode state and roll out from it
+  simu->restore(initial);
+  simu->run(2.0);
+  robox2d::Snapshot branch = simu->snapshot();
+  auto rob = std::static_pointer_cast<bench::Arm>(simu->robot(0));
+  simu->run(1.0);
+  b2Vec2 first = rob->get_end_effector_pos();
+  simu->restore(branch);
+  simu->run(1.0);
+  b2Vec2 second = rob->get_end_effector_pos();
+
+  std::cout << "rebuild: " << 1e6 * rebuild_time / nb_resets << " us/reset" << std::endl;
+  std::cout << "restore: " << 1e6 * restore_time / nb_resets << " us/reset" << std::endl;
+  std::cout << "branch end effector: (" << first.x << ", " << first.y << ") vs (" << second.x << ", " << second.y << ")" << std::endl;
+  return 0;
+}
@@ -0,0 +1,63 @@
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+#include <robox2d/descriptor/trajectory_recorder.hpp>
+
+#include "bench_robots.hpp"
+
+// Cost of recording a trajectory at every physic step, size of the file and cost of random access to the frames.
+
+int main()
+{
+  const double duration = 100.0; // 10000 steps at 100 Hz
+  const std::string filename = "bench_trajectory.rbx2";
+
+  auto simu = bench::make_arm_simu();
+  double t_plain = bench::timeit([&]() { simu->run(duration); });
+
+  simu = bench::make_arm_simu();
+  auto recorder = std::make_shared<robox2d::descriptor::TrajectoryRecorder>(filename);
+  simu->add_descriptor(recorder);
+  double t_record = bench::timeit([&]() {
+    simu->run(duration);
+    recorder->close();
+  });
+  size_t nb_frames = recorder->nb_frames();
+
+  robox2d::trajectory::Reader reader(filename);
+  if (!reader.good()) {
+    std::cout << "cannot read " << filename << std::endl;
+    return 1;
+  }
+  FILE* f = std::fopen(filename.c_str(), "rb");
+  std::fseek(f, 0, SEEK_END);
+  long size = std::ftell(f);
+  std::fclose(f);
+
+  const size_t nb_reads = 1000000;
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> dist(0, nb_frames - 1);
+  double sum = 0;
+  double t_read = bench::timeit([&]() {
+    for (size_t i = 0; i < nb_reads; i++) {
+      auto frame = reader.frame(dist(gen));
+      sum += frame.x[0] + frame.joints[0];
+    }
+  });
+
+  // replay in a fresh simu (same construction, so same bodies) without stepping
+  auto replay_simu = bench::make_arm_simu();
+  double t_apply = bench::timeit([&]() {
+    for (size_t i = 0; i < nb_frames; i++)
+      reader.apply(*replay_simu->world(), i);
+  });
+
+  std::cout << "frames: " << nb_frames << " (" << reader.nb_bodies() << " bodies, " << reader.nb_joints() << " joints, "
+	    << reader.nb_inputs() << " inputs), " << size / 1024.0 << " KiB" << std::endl;
+  std::cout << "run: " << 1e6 * t_plain / nb_frames << " us/step, with recorder: " << 1e6 * t_record / nb_frames << " us/step" << std::endl;
+  std::cout << "random frame access: " << 1e9 * t_read / nb_reads << " ns (checksum " << sum << ")" << std::endl;
+  std::cout << "replay (apply): " << 1e6 * t_apply / nb_frames << " us/frame" << std::endl;
+  std::remove(filename.c_str());
+  return 0;
+}
@@ -39,6 +39,13 @@ public:
     
   }
   
+  std::shared_ptr<robox2d::Robot> clone(robox2d::CloneMap& map) const override
+  {
+    auto copy = _clone_as<Arm>(map);
+    copy->_end_effector = map.body(_end_effector);
+    return copy;
+  }
+
   b2Vec2 get_end_effector_pos(){return _end_effector->GetWorldCenter(); }
   
 private:
@@ -41,6 +41,13 @@ public:
     
   }
   
+  std::shared_ptr<robox2d::Robot> clone(robox2d::CloneMap& map) const override
+  {
+    auto copy = _clone_as<Car>(map);
+    copy->_hull = map.body(_hull);
+    return copy;
+  }
+
   b2Vec2 get_hull_pos(){return _hull->GetWorldCenter(); }
   
 private:
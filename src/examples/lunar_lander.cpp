@@ -19,6 +19,7 @@ public:
     float hull_size = 0.1;
    
     _hull = robox2d::common::createBox( world,{hull_size, hull_size*0.75f}, b2_dynamicBody,  {0.0f,0.0f,0.0f}, 1.0f );
+    add_body(_hull);
     robox2d::common::createBox( world,{10.0f, 0.5f}, b2_staticBody,  {0.0f,-1.0f,0.0f} );// ground
     
     // body will always represent the body created in the previous iteration
@@ -61,9 +62,14 @@ public:
     
   }
   
+  std::shared_ptr<robox2d::Robot> clone(robox2d::CloneMap& map) const override
+  {
+    auto copy = _clone_as<LunarLander>(map);
+    copy->_hull = map.body(_hull);
+    return copy;
+  }
+
   b2Vec2 get_hull_pos(){return _hull->GetWorldCenter(); }
-  b2Vec2 get_hull_lin_vel(){return _hull->GetLinearVelocity(); }
-  float get_hull_rot_vel(){return _hull->GetAngularVelocity(); }
   
 private:
   b2Body* _hull;
@@ -74,34 +80,34 @@ class LanderController: public robox2d::control::BaseController {
     public:
       LanderController(): robox2d::control::BaseController(4){}
       
-      Eigen::VectorXd commands(double t, robox2d::Robot* robot){
-	auto rob = static_cast<LunarLander*>(robot);
-	Eigen::VectorXd cmd=Eigen::VectorXd::Zero(this->_nb_dofs);
+      void write_commands(double t, robox2d::Robot* robot, Eigen::Ref<Eigen::VectorXd> cmd){
+	// velocity of the hull: vx, vy and angular velocity
+	auto vel = robot->body_velocity(0);
+	cmd.setZero();
 
 	
 	
-	std::cout<<rob->get_hull_lin_vel().y<<" "<<rob->get_hull_rot_vel()<<std::endl;
+	std::cout<<vel[1]<<" "<<vel[2]<<std::endl;
 
-	if(std::abs(rob->get_hull_rot_vel())>0.001)
+	if(std::abs(vel[2])>0.001)
 	  {
-	   if(rob->get_hull_rot_vel() > 0)
-	     cmd[2]+= std::min(std::max(std::abs(rob->get_hull_rot_vel())/50.0f, 0.0f), 0.01f);
+	   if(vel[2] > 0)
+	     cmd[2]+= std::min(std::max(std::abs(vel[2])/50.0, 0.0), 0.01);
 	   else
-	     cmd[3]+= std::min(std::max(std::abs(rob->get_hull_rot_vel())/50.0f, 0.0f), 0.01f);
+	     cmd[3]+= std::min(std::max(std::abs(vel[2])/50.0, 0.0), 0.01);
 	  }
 	
-	if(rob->get_hull_lin_vel().x < 0)
-	  cmd[2]+= std::min(std::max(std::abs(rob->get_hull_lin_vel().x)/100.0f, 0.0f), 0.01f);
+	if(vel[0] < 0)
+	  cmd[2]+= std::min(std::max(std::abs(vel[0])/100.0, 0.0), 0.01);
 	else
-	  cmd[3]+= std::min(std::max(std::abs(rob->get_hull_lin_vel().x)/100.0f, 0.0f), 0.01f);
+	  cmd[3]+= std::min(std::max(std::abs(vel[0])/100.0, 0.0), 0.01);
 
-	if(std::abs(rob->get_hull_lin_vel().Length())>0.001)
-	  if(rob->get_hull_lin_vel().y<0)
+	if(vel.head<2>().norm()>0.001)
+	  if(vel[1]<0)
 	    {
-	      cmd[0]= std::min(std::max(-rob->get_hull_lin_vel().y/400.0f, 0.0f), 0.02f);
-	      cmd[1]= std::min(std::max(-rob->get_hull_lin_vel().y/200.0f, 0.0f), 0.02f); // simulated defect in one reactor
+	      cmd[0]= std::min(std::max(-vel[1]/400.0, 0.0), 0.02);
+	      cmd[1]= std::min(std::max(-vel[1]/200.0, 0.0), 0.02); // simulated defect in one reactor
 	    }
-	return cmd;
       }
   
     };
@@ -0,0 +1,306 @@
+#include "action_log.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "hash.hpp"
+#include "simu.hpp"
+
+namespace robox2d {
+
+  constexpr size_t ActionLogger::npos;
+
+  // CommandEncoder / CommandDecoder
+
+  void CommandEncoder::encode(const double* cmd, std::vector<uint8_t>& out)
+  {
+    for (size_t i = 0; i < _previous.size(); i++) {
+      uint64_t bits;
+      std::memcpy(&bits, cmd + i, sizeof(double));
+      uint64_t x = bits ^ _previous[i];
+      _previous[i] = bits;
+
+      // count the zero bytes at both ends
+      unsigned lz = 0, tz = 0;
+      while (lz < 8 && ((x >> (8 * (7 - lz))) & 0xff) == 0)
+	lz++;
+      if (lz < 8)
+	while (((x >> (8 * tz)) & 0xff) == 0)
+	  tz++;
+      out.push_back(uint8_t((lz << 4) | tz));
+      for (unsigned b = tz; b < 8 - lz; b++)
+	out.push_back(uint8_t(x >> (8 * b)));
+    }
+  }
+
+  const uint8_t* CommandDecoder::decode(const uint8_t* in, const uint8_t* end, double* cmd)
+  {
+    // check the whole vector first: nothing is decoded from a truncated or corrupted one
+    const uint8_t* p = in;
+    for (size_t i = 0; i < _previous.size(); i++) {
+      if (p >= end)
+	return nullptr;
+      unsigned lz = *p >> 4, tz = *p & 0x0f;
+      if (lz + tz > 8 || (lz < 8 && tz == 8 - lz) || size_t(end - p - 1) < 8 - lz - tz)
+	return nullptr;
+      p += 1 + 8 - lz - tz;
+    }
+
+    for (size_t i = 0; i < _previous.size(); i++) {
+      unsigned lz = *in >> 4, tz = *in & 0x0f;
+      in++;
+      uint64_t x = 0;
+      for (unsigned b = tz; b < 8 - lz; b++)
+	x |= uint64_t(*in++) << (8 * b);
+      _previous[i] ^= x;
+      std::memcpy(cmd + i, &_previous[i], sizeof(double));
+    }
+    return in;
+  }
+
+  // ActionLog
+
+  namespace {
+    const char magic[8] = {'R', 'B', 'X', '2', 'A', 'C', 'T', 'S'};
+    const uint32_t version = 2; // 2: hashes with their ticks
+
+    template <typename T>
+    void write_pod(std::ofstream& out, const T& value) { out.write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+    template <typename T>
+    void read_pod(std::ifstream& in, T& value) { in.read(reinterpret_cast<char*>(&value), sizeof(T)); }
+
+    template <typename T>
+    void write_vector(std::ofstream& out, const std::vector<T>& v)
+    {
+      write_pod(out, uint64_t(v.size()));
+      out.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+    }
+
+    /* Bytes left in the file */
+    uint64_t remaining(std::ifstream& in)
+    {
+      std::streampos pos = in.tellg();
+      in.seekg(0, std::ios::end);
+      std::streampos end = in.tellg();
+      in.seekg(pos);
+      return in ? uint64_t(end - pos) : 0;
+    }
+
+    /* Fails (sets the failbit) instead of allocating a size larger than the rest of the file */
+    template <typename T>
+    void read_vector(std::ifstream& in, std::vector<T>& v)
+    {
+      uint64_t size = 0;
+      read_pod(in, size);
+      if (!in)
+	return;
+      if (size > remaining(in) / sizeof(T)) {
+	in.setstate(std::ios::failbit);
+	return;
+      }
+      v.resize(size);
+      in.read(reinterpret_cast<char*>(v.data()), size * sizeof(T));
+    }
+  } // namespace
+
+  size_t ActionLog::nb_bytes() const
+  {
+    size_t n = config.size() + hashes.size() * sizeof(HashStream::Entry);
+    for (auto& r : robots)
+      n += r.data.size();
+    return n;
+  }
+
+  bool ActionLog::save(const std::string& filename) const
+  {
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    out.write(magic, sizeof(magic));
+    write_pod(out, version);
+    write_pod(out, seed);
+    write_pod(out, physic_freq);
+    write_pod(out, control_freq);
+    write_pod(out, hash_period);
+    write_vector(out, std::vector<char>(config.begin(), config.end()));
+    write_pod(out, uint32_t(robots.size()));
+    for (auto& r : robots) {
+      write_pod(out, r.nb_dofs);
+      write_pod(out, r.nb_ticks);
+      write_vector(out, r.data);
+    }
+    write_vector(out, hashes.entries());
+    return out.good();
+  }
+
+  bool ActionLog::load(const std::string& filename)
+  {
+    std::ifstream in(filename, std::ios::binary);
+    char m[8] = {0};
+    uint32_t v = 0;
+    in.read(m, sizeof(m));
+    read_pod(in, v);
+    if (!in || std::memcmp(m, magic, sizeof(magic)) != 0 || v != version) {
+      std::cout << "Warning: not an action log: " << filename << std::endl;
+      return false;
+    }
+    read_pod(in, seed);
+    read_pod(in, physic_freq);
+    read_pod(in, control_freq);
+    read_pod(in, hash_period);
+    std::vector<char> c;
+    read_vector(in, c);
+    config.assign(c.begin(), c.end());
+    uint32_t nb_robots = 0;
+    read_pod(in, nb_robots);
+    // a stream takes at least 12 bytes
+    if (!in || nb_robots > remaining(in) / 12) {
+      std::cout << "Warning: corrupted action log: " << filename << std::endl;
+      return false;
+    }
+    robots.assign(nb_robots, Stream());
+    for (auto& r : robots) {
+      read_pod(in, r.nb_dofs);
+      read_pod(in, r.nb_ticks);
+      read_vector(in, r.data);
+      // every vector takes at least nb_dofs bytes, and the commands must fill the data exactly
+      if (!in || (r.nb_dofs > 0 && r.nb_ticks > r.data.size() / r.nb_dofs) || (r.nb_dofs == 0 && !r.data.empty())
+	  || !_check_stream(r)) {
+	std::cout << "Warning: corrupted action log: " << filename << std::endl;
+	return false;
+      }
+    }
+    std::vector<HashStream::Entry> entries;
+    read_vector(in, entries);
+    hashes.clear();
+    hashes.reserve(entries.size());
+    for (auto& e : entries)
+      hashes.push_back(e.tick, e.hash);
+    if (!in)
+      std::cout << "Warning: corrupted action log: " << filename << std::endl;
+    return in.good();
+  }
+
+  bool ActionLog::_check_stream(const Stream& stream)
+  {
+    CommandDecoder decoder;
+    decoder.reset(stream.nb_dofs);
+    std::vector<double> cmd(stream.nb_dofs);
+    const uint8_t* p = stream.data.data();
+    const uint8_t* end = p + stream.data.size();
+    for (uint64_t k = 0; k < stream.nb_ticks; k++)
+      if (!(p = decoder.decode(p, end, cmd.data())))
+	return false;
+    return p == end;
+  }
+
+  // ActionLogger
+
+  ActionLogger::ActionLogger(Mode mode, const std::shared_ptr<ActionLog>& log) : _mode(mode), _log(log)
+  {
+    assert(log && "ActionLogger needs a log");
+  }
+
+  void ActionLogger::attach(Simu& simu)
+  {
+    _nb_steps = 0;
+    _divergence = npos;
+    _divergence_tick = npos;
+    _start_tick = simu.tick();
+    _first_hash = _next_hash = simu.state_hashes().size();
+    simu.enable_state_hash(true, _log->hash_period);
+    auto robots = simu.robots();
+
+    if (_mode == Record) {
+      // the seed and the configuration are set by the user
+      _log->physic_freq = std::llround(1.0 / simu.physic_period());
+      _log->control_freq = std::llround(1.0 / simu.control_period());
+      _log->hashes.clear();
+      _log->robots.assign(robots.size(), ActionLog::Stream());
+      _encoders.assign(robots.size(), CommandEncoder());
+      for (size_t i = 0; i < robots.size(); i++) {
+	_log->robots[i].nb_dofs = robots[i]->nb_dofs();
+	_encoders[i].reset(robots[i]->nb_dofs());
+      }
+      return;
+    }
+
+    if (robots.size() != _log->robots.size())
+      std::cout << "Warning: the simu has " << robots.size() << " robots, the action log " << _log->robots.size() << std::endl;
+    for (size_t i = 0; i < robots.size() && i < _log->robots.size(); i++) {
+      if (robots[i]->nb_dofs() != _log->robots[i].nb_dofs) {
+	std::cout << "Warning: robot " << i << " has " << robots[i]->nb_dofs() << " dofs, the action log "
+		  << _log->robots[i].nb_dofs << ": not replayed" << std::endl;
+	continue;
+      }
+      robots[i]->clear_controllers();
+      robots[i]->add_controller(std::make_shared<control::Replay>(_log, i));
+    }
+  }
+
+  void ActionLogger::control_update(const Simu& simu)
+  {
+    if (_mode != Record)
+      return;
+    auto robots = simu.robots();
+    assert(robots.size() == _log->robots.size() && "Robots added or removed while recording");
+    for (size_t i = 0; i < robots.size(); i++) {
+      const Eigen::VectorXd& commands = robots[i]->commands();
+      assert(size_t(commands.size()) == _log->robots[i].nb_dofs && "Actuators added or removed while recording");
+      _encoders[i].encode(commands.data(), _log->robots[i].data);
+      _log->robots[i].nb_ticks++;
+    }
+  }
+
+  bool ActionLogger::physic_update(Simu& simu)
+  {
+    size_t step = _nb_steps++;
+    const HashStream& hashes = simu.state_hashes();
+    assert(hashes.size() >= _next_hash && "State hashes cleared while logging actions");
+    for (; _next_hash < hashes.size(); _next_hash++) {
+      const HashStream::Entry& entry = hashes[_next_hash];
+      const uint64_t tick = entry.tick - _start_tick;
+      if (_mode == Record) {
+	_log->hashes.push_back(tick, entry.hash);
+	continue;
+      }
+
+      size_t k = _next_hash - _first_hash;
+      if (_divergence != npos || k >= _log->hashes.size())
+	continue;
+      if (_log->hashes[k].tick != tick || _log->hashes[k].hash != entry.hash) {
+	_divergence = step;
+	_divergence_tick = entry.tick;
+      }
+    }
+    return _divergence == npos;
+  }
+
+  namespace control {
+    Replay::Replay(const std::shared_ptr<ActionLog>& log, size_t robot) :
+      BaseController(log->robots[robot].nb_dofs),
+      _log(log),
+      _robot(robot),
+      _next(log->robots[robot].data.data()),
+      _end(_next + log->robots[robot].data.size()),
+      _tick(0),
+      _cmd(Eigen::VectorXd::Zero(log->robots[robot].nb_dofs))
+    {
+      _decoder.reset(_nb_dofs);
+    }
+
+    void Replay::write_commands(double t, robox2d::Robot* robot, Eigen::Ref<Eigen::VectorXd> cmd)
+    {
+      if (_next && _tick < _log->robots[_robot].nb_ticks) {
+	// the data may have been changed since the log was loaded: a truncated stream ends the replay
+	_next = _decoder.decode(_next, _end, _cmd.data());
+	if (_next)
+	  _tick++;
+	else
+	  std::cout << "Warning: the commands of robot " << _robot << " end at tick " << _tick << " in the action log" << std::endl;
+      }
+      cmd = _cmd;
+    }
+  } // namespace control
+} // namespace robox2d
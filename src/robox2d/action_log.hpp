@@ -0,0 +1,149 @@
+#ifndef ROBOX2D_ACTION_LOG_HPP
+#define ROBOX2D_ACTION_LOG_HPP
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "robox2d/hash.hpp"
+#include "robox2d/robot.hpp"
+
+namespace robox2d {
+  class Simu;
+
+  /**
+   * @brief Lossless delta encoding of command vectors.
+   *
+   * Each command is XORed with the same command at the previous tick; the leading and trailing zero bytes of the
+   * result are stripped (one header byte gives their count). An unchanged command takes 1 byte, a slowly varying
+   * one 3 to 6 bytes instead of 8.
+   */
+  class CommandEncoder {
+  public:
+    void reset(size_t size) { _previous.assign(size, 0); }
+    void encode(const double* cmd, std::vector<uint8_t>& out);
+
+  protected:
+    std::vector<uint64_t> _previous;
+  };
+
+  class CommandDecoder {
+  public:
+    void reset(size_t size) { _previous.assign(size, 0); }
+    /* Decode one vector from [in, end) and return the position of the next one (nullptr, and nothing decoded, if
+       the vector is truncated or invalid) */
+    const uint8_t* decode(const uint8_t* in, const uint8_t* end, double* cmd);
+
+  protected:
+    std::vector<uint64_t> _previous;
+  };
+
+  /**
+   * @brief Everything needed to reproduce an episode: seed and configuration (to rebuild the simu), the commands
+   * of every robot at every control tick and the state hashes of the simu (see Simu::enable_state_hash) every
+   * hash_period physic steps, with ticks counted from the start of the recording.
+   */
+  struct ActionLog {
+    struct Stream {
+      uint32_t nb_dofs = 0;
+      uint64_t nb_ticks = 0;
+      std::vector<uint8_t> data; // encoded with CommandEncoder
+    };
+
+    uint64_t seed = 0;
+    std::string config; // free-form, to be interpreted by the code building the simu
+    uint32_t physic_freq = 0;
+    uint32_t control_freq = 0;
+    uint32_t hash_period = 1;
+
+    std::vector<Stream> robots;
+    HashStream hashes;
+
+    size_t nb_bytes() const;
+
+    bool save(const std::string& filename) const;
+    /* False (with a warning) if the file is not an action log, or is truncated or corrupted */
+    bool load(const std::string& filename);
+
+  protected:
+    /* The data of the stream holds exactly nb_ticks valid vectors */
+    static bool _check_stream(const Stream& stream);
+  };
+
+  /**
+   * @brief Records an ActionLog from a simu, or replays one and checks the world hashes (see Simu::set_action_logger).
+   *
+   * In Replay mode the controllers of the robots are replaced by control::Replay controllers; the simu must have
+   * been rebuilt in the state it had when the recording started (e.g. from the seed and the configuration of the
+   * log). The run then stops at the first physic step where the hash of the world differs from the log.
+   *
+   * attach() enables the state hash of the simu with the period of the log; the hashes are taken from
+   * Simu::state_hashes() (recorded in the log, or compared as with first_divergence).
+   */
+  class ActionLogger {
+  public:
+    enum Mode { Record, Replay };
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    ActionLogger(Mode mode, const std::shared_ptr<ActionLog>& log);
+
+    /* Called by Simu::set_action_logger: reset the log (Record) or install the Replay controllers (Replay) */
+    void attach(Simu& simu);
+    /* Called by Simu::run after the control update of the robots */
+    void control_update(const Simu& simu);
+    /* Called by Simu::run after each physic step: false if the world diverged from the log */
+    bool physic_update(Simu& simu);
+
+    Mode mode() const { return _mode; }
+    const std::shared_ptr<ActionLog>& log() const { return _log; }
+    /* Physic steps since attach */
+    size_t nb_steps() const { return _nb_steps; }
+    /* Physic step (since attach) and simu tick of the first divergence, npos if none */
+    size_t divergence() const { return _divergence; }
+    size_t divergence_tick() const { return _divergence_tick; }
+
+  protected:
+    Mode _mode;
+    std::shared_ptr<ActionLog> _log;
+    std::vector<CommandEncoder> _encoders;
+    size_t _nb_steps = 0;
+    size_t _start_tick = 0; // simu tick at attach
+    size_t _first_hash = 0; // entries of Simu::state_hashes() from before attach
+    size_t _next_hash = 0; // next entry to record or compare
+    size_t _divergence = npos;
+    size_t _divergence_tick = npos;
+  };
+
+  namespace control {
+
+    /**
+     * @brief Sends the commands recorded for one robot in an ActionLog (the last ones once the log is over).
+     */
+    class Replay : public BaseController {
+    public:
+      Replay(const std::shared_ptr<ActionLog>& log, size_t robot);
+
+      void write_commands(double t, robox2d::Robot* robot, Eigen::Ref<Eigen::VectorXd> cmd) override;
+
+      /* The position in the log is copied, the log itself is shared */
+      std::shared_ptr<BaseController> clone() const override { return std::make_shared<Replay>(*this); }
+
+      size_t nb_ticks() const { return _tick; }
+
+    protected:
+      std::shared_ptr<ActionLog> _log;
+      size_t _robot;
+      CommandDecoder _decoder;
+      const uint8_t* _next; // nullptr once the data is exhausted
+      const uint8_t* _end;
+      size_t _tick;
+      Eigen::VectorXd _cmd;
+    };
+  } // namespace control
+} // namespace robox2d
+
+#endif
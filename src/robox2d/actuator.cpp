@@ -1,7 +1,9 @@
 #include <box2d/box2d.h>
 
+#include <cmath>
 #include <iostream>
 #include "actuator.hpp"
+#include "actuator_bank.hpp"
 
 namespace robox2d {
   namespace actuator {
@@ -32,8 +34,31 @@ namespace robox2d {
     }
     
     
+    void Servo::set_input(double input){
+      _input = input;
+      if (_bank)
+	_bank->set_input(_slot, input);
+    }
+
+    void Servo::set_tolerance(double tolerance){
+      _tolerance = tolerance;
+      if (_bank)
+	_bank->set_tolerance(_slot, tolerance);
+    }
+
     void Servo::update(){
-      _joint->SetMotorSpeed(_gain * (_input - _joint->GetJointAngle() ));
+      float speed = _gain * (_input - _joint->GetJointAngle() );
+      // keep the motor speed for a negligible change: SetMotorSpeed would wake the bodies up and reset their sleep timer
+      if (std::abs(speed - _joint->GetMotorSpeed()) <= _tolerance)
+	return;
+      _joint->SetMotorSpeed(speed);
+    }
+
+    std::shared_ptr<Actuator> Servo::clone(CloneMap& map) const{
+      auto servo = std::make_shared<Servo>(*this);
+      servo->_joint = static_cast<b2RevoluteJoint*>(map.joint(_joint));
+      servo->_bank = nullptr;
+      return servo;
     }
 
 
@@ -42,8 +67,18 @@ namespace robox2d {
     
     
     void PonctualForce::update(){
+      // a negligible impulse is still applied to an awake body, but does not wake up a sleeping one
+      bool wake = std::abs(_input) > _tolerance;
+      if (!wake && !_body->IsAwake())
+	return;
       auto f = _input*_body->GetWorldVector(_direction);
-      _body->ApplyLinearImpulse(f , _body->GetWorldPoint(_anchor), true);
+      _body->ApplyLinearImpulse(f , _body->GetWorldPoint(_anchor), wake);
+    }
+
+    std::shared_ptr<Actuator> PonctualForce::clone(CloneMap& map) const{
+      auto force = std::make_shared<PonctualForce>(*this);
+      force->_body = map.body(_body);
+      return force;
     }
 
     
@@ -95,7 +130,27 @@ namespace robox2d {
       //apply force
       b2Vec2 force_vec= { p_force*side.x + f_force*forw.x,   p_force*side.y + f_force*forw.y};
       
-      _body->ApplyForceToCenter( force_vec,  true);
+      bool wake = force > _force_tolerance;
+      if (wake || _body->IsAwake())
+	_body->ApplyForceToCenter( force_vec,  wake);
+    }
+
+    std::shared_ptr<Actuator> WheelTraction::clone(CloneMap& map) const{
+      auto wheel = std::make_shared<WheelTraction>(*this);
+      wheel->_body = map.body(_body);
+      return wheel;
+    }
+
+    void WheelTraction::save_state(double* state) const{
+      state[0] = _input;
+      state[1] = _gas;
+      state[2] = _omega;
+    }
+
+    void WheelTraction::load_state(const double* state){
+      _input = state[0];
+      _gas = state[1];
+      _omega = state[2];
     }
 
   }
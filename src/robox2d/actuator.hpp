@@ -10,10 +10,13 @@
 
 #include <box2d/box2d.h>
 
+#include "clone_map.hpp"
 
 namespace robox2d {
   namespace actuator {
 
+    class ServoBank;
+
     /**
      * @brief Actuator is an abstract class for actuators (servos, ...) 
      * 
@@ -22,14 +25,39 @@ namespace robox2d {
      */
     class Actuator{
     public:
-      Actuator() : _input(0.0) {}
+      Actuator() : _input(0.0), _tolerance(0.0) {}
+            
+      virtual ~Actuator() {}
             
       virtual void set_input(double input){_input=input;};
+      double input() const {return _input;}
       
       virtual void update()=0;
+
+      /**
+       * @brief Commands (or changes of commands) smaller than the tolerance do not wake up sleeping bodies.
+       *
+       * The unit is the one of the quantity the actuator sets: motor speed (rad/s) for a Servo, which keeps its
+       * motor speed while it is within the tolerance of the target speed (so the joint can settle and sleep);
+       * impulse for a PonctualForce. WheelTraction ignores it (see WheelTraction::set_force_tolerance).
+       * With the default tolerance (0), only null or unchanged commands are skipped. A negative tolerance
+       * disables the skipping: a Servo sets its motor speed at every update (Box2D only wakes the bodies when the
+       * speed actually changes) and a PonctualForce applies every impulse, waking its body even for a null one.
+       */
+      virtual void set_tolerance(double tolerance) {_tolerance=tolerance;}
+      double tolerance() const {return _tolerance;}
+
+      /* Internal state of the actuator (used by Simu::snapshot/restore) */
+      virtual size_t state_size() const {return 1;}
+      virtual void save_state(double* state) const {state[0]=_input;}
+      virtual void load_state(const double* state) {_input=state[0];}
+
+      /* Copy of the actuator acting on the bodies/joints cloned in map (nullptr if not supported) */
+      virtual std::shared_ptr<Actuator> clone(CloneMap& map) const {return nullptr;}
       
     protected:
       double _input;
+      double _tolerance;
     };
 
 
@@ -43,15 +71,26 @@ namespace robox2d {
       public:
           Servo(std::shared_ptr <b2World> world, b2Body *bodyA, b2Body *bodyB, const b2Vec2 &anchor, double gain = 0.3);
 
+          void set_input(double input);
+          void set_tolerance(double tolerance);
+
           void update();
 
+          void load_state(const double* state) { set_input(state[0]); }
+
+          std::shared_ptr<Actuator> clone(CloneMap& map) const;
+
           b2RevoluteJoint *get_joint() { return _joint; }
 
           const b2RevoluteJoint *get_joint() const { return _joint; }
 
       private:
+          friend class ServoBank;
+
           b2RevoluteJoint *_joint;
           double _gain;
+          ServoBank *_bank = nullptr; // bank updating this servo (see Robot::physic_update)
+          size_t _slot = 0;
       };
 
 
@@ -68,6 +107,8 @@ namespace robox2d {
       
             
       void update();
+
+      std::shared_ptr<Actuator> clone(CloneMap& map) const;
       
     private:
       b2Body* _body;
@@ -92,12 +133,23 @@ namespace robox2d {
       
             
       void update();
+
+      /* Forces (N) below the tolerance do not wake up a sleeping wheel (0 by default) */
+      void set_force_tolerance(double tolerance) { _force_tolerance = tolerance; }
+      double force_tolerance() const { return _force_tolerance; }
+
+      size_t state_size() const {return 3;}
+      void save_state(double* state) const;
+      void load_state(const double* state);
+
+      std::shared_ptr<Actuator> clone(CloneMap& map) const;
       
     private:
       
       b2Body* _body;
       float _gas; // if gas is negative, then it is braking      
       float _omega; // angular velocity
+      double _force_tolerance = 0.0;
 
       const float dt=0.01;
       const float size=0.001;
@@ -0,0 +1,55 @@
+#include "actuator_bank.hpp"
+
+#include <cmath>
+
+namespace robox2d {
+  namespace actuator {
+
+    void ServoBank::clear(){
+      for (auto& servo : _servos)
+	servo->_bank = nullptr;
+      _servos.clear();
+      _joints.clear();
+      _gains.resize(0);
+      _inputs.resize(0);
+      _tolerances.resize(0);
+      _angles.resize(0);
+      _speeds.resize(0);
+    }
+
+    void ServoBank::add(const std::shared_ptr<Servo>& servo){
+      size_t n = _joints.size();
+      _servos.push_back(servo);
+      _joints.push_back(servo->get_joint());
+
+      _gains.conservativeResize(n + 1);
+      _inputs.conservativeResize(n + 1);
+      _tolerances.conservativeResize(n + 1);
+      _angles.resize(n + 1);
+      _speeds.resize(n + 1);
+      _gains[n] = servo->_gain;
+      _inputs[n] = servo->input();
+      _tolerances[n] = servo->tolerance();
+
+      servo->_bank = this;
+      servo->_slot = n;
+    }
+
+    void ServoBank::update(){
+      const size_t n = _joints.size();
+      for (size_t i = 0; i < n; i++)
+	_angles[i] = _joints[i]->GetJointAngle();
+
+      _speeds = _gains * (_inputs - _angles);
+
+      // same rule as Servo::update: negligible changes of speed are skipped
+      for (size_t i = 0; i < n; i++) {
+	b2RevoluteJoint* joint = _joints[i];
+	float speed = _speeds[i];
+	if (std::abs(speed - joint->GetMotorSpeed()) <= _tolerances[i])
+	  continue;
+	joint->SetMotorSpeed(speed);
+      }
+    }
+  }
+}
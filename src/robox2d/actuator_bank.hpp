@@ -0,0 +1,53 @@
+#ifndef ROBOX2D_ACTUATOR_BANK_HPP
+#define ROBOX2D_ACTUATOR_BANK_HPP
+
+#include <memory>
+#include <vector>
+
+#include <Eigen/Core>
+#include <box2d/box2d.h>
+
+#include "actuator.hpp"
+
+namespace robox2d {
+  namespace actuator {
+
+    /**
+     * @brief ServoBank stores the servos of a robot as arrays (gains, inputs, joints) and updates them all at once.
+     * 
+     * The servo law `gain * (input - angle)` is evaluated on the whole bank with Eigen arrays (vectorized), and
+     * only the reads of the joint angles and the writes of the motor speeds remain per joint.
+     * The Servo objects stay valid: once added to a bank, Servo::set_input also writes the input of the bank.
+     */
+    class ServoBank {
+    public:
+      ServoBank() {}
+      // a copy (e.g. in a copied Robot) starts empty: the servos stay bound to the original bank
+      ServoBank(const ServoBank&) {}
+      ServoBank& operator=(const ServoBank&) { clear(); return *this; }
+      ~ServoBank() { clear(); }
+
+      void clear();
+      void add(const std::shared_ptr<Servo>& servo);
+
+      size_t size() const { return _joints.size(); }
+
+      void set_input(size_t index, double input) { _inputs[index] = input; }
+      double input(size_t index) const { return _inputs[index]; }
+      void set_tolerance(size_t index, double tolerance) { _tolerances[index] = tolerance; }
+
+      void update();
+
+    protected:
+      std::vector<std::shared_ptr<Servo>> _servos;
+      std::vector<b2RevoluteJoint*> _joints;
+      Eigen::ArrayXd _gains;
+      Eigen::ArrayXd _inputs;
+      Eigen::ArrayXd _tolerances;
+      Eigen::ArrayXd _angles;
+      Eigen::ArrayXd _speeds;
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,206 @@
+#include "clone_map.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace robox2d {
+
+  b2Body* CloneMap::body(b2Body* src)
+  {
+    auto it = _bodies.find(src);
+    if (it != _bodies.end())
+      return it->second;
+
+    // clone the whole articulated structure: bodies first, then the joints between them
+    std::vector<b2Body*> stack{src};
+    std::vector<b2Joint*> joints;
+    _bodies[src] = _clone_body(src);
+    while (!stack.empty()) {
+      b2Body* b = stack.back();
+      stack.pop_back();
+      for (b2JointEdge* edge = b->GetJointList(); edge; edge = edge->next) {
+	if (_bodies.find(edge->other) == _bodies.end()) {
+	  _bodies[edge->other] = _clone_body(edge->other);
+	  stack.push_back(edge->other);
+	}
+	if (_joints.find(edge->joint) == _joints.end() && std::find(joints.begin(), joints.end(), edge->joint) == joints.end())
+	  joints.push_back(edge->joint);
+      }
+    }
+    for (b2Joint* j : joints)
+      _joints[j] = _clone_joint(j);
+
+    return _bodies[src];
+  }
+
+  b2Joint* CloneMap::joint(b2Joint* src)
+  {
+    auto it = _joints.find(src);
+    if (it != _joints.end())
+      return it->second;
+    body(src->GetBodyA());
+    return _joints[src];
+  }
+
+  void CloneMap::clone_world(b2World& src)
+  {
+    // b2World lists are ordered from the newest to the oldest
+    std::vector<b2Body*> bodies;
+    for (b2Body* b = src.GetBodyList(); b; b = b->GetNext())
+      bodies.push_back(b);
+    for (auto b = bodies.rbegin(); b != bodies.rend(); ++b)
+      if (_bodies.find(*b) == _bodies.end())
+	_bodies[*b] = _clone_body(*b);
+
+    std::vector<b2Joint*> joints;
+    for (b2Joint* j = src.GetJointList(); j; j = j->GetNext())
+      joints.push_back(j);
+    for (auto j = joints.rbegin(); j != joints.rend(); ++j)
+      if (_joints.find(*j) == _joints.end())
+	_joints[*j] = _clone_joint(*j);
+  }
+
+  b2Body* CloneMap::_clone_body(b2Body* src)
+  {
+    b2BodyDef def;
+    def.type = src->GetType();
+    def.position = src->GetPosition();
+    def.angle = src->GetAngle();
+    def.linearVelocity = src->GetLinearVelocity();
+    def.angularVelocity = src->GetAngularVelocity();
+    def.linearDamping = src->GetLinearDamping();
+    def.angularDamping = src->GetAngularDamping();
+    def.allowSleep = src->IsSleepingAllowed();
+    def.awake = src->IsAwake();
+    def.fixedRotation = src->IsFixedRotation();
+    def.bullet = src->IsBullet();
+    def.enabled = src->IsEnabled();
+    def.gravityScale = src->GetGravityScale();
+    b2Body* body = _world->CreateBody(&def);
+
+    // fixtures are also ordered from the newest to the oldest
+    std::vector<b2Fixture*> fixtures;
+    for (b2Fixture* f = src->GetFixtureList(); f; f = f->GetNext())
+      fixtures.push_back(f);
+    for (auto f = fixtures.rbegin(); f != fixtures.rend(); ++f) {
+      b2FixtureDef fixture;
+      fixture.shape = (*f)->GetShape();
+      fixture.friction = (*f)->GetFriction();
+      fixture.restitution = (*f)->GetRestitution();
+      fixture.density = (*f)->GetDensity();
+      fixture.isSensor = (*f)->IsSensor();
+      fixture.filter = (*f)->GetFilterData();
+      body->CreateFixture(&fixture);
+    }
+
+    // keep the mass properties if they were set by hand
+    if (def.type == b2_dynamicBody) {
+      b2MassData mass;
+      src->GetMassData(&mass);
+      body->SetMassData(&mass);
+    }
+    return body;
+  }
+
+  b2Joint* CloneMap::_clone_joint(b2Joint* src)
+  {
+    b2Body* bodyA = _bodies.at(src->GetBodyA());
+    b2Body* bodyB = _bodies.at(src->GetBodyB());
+
+    switch (src->GetType()) {
+    case e_revoluteJoint:
+      {
+	auto j = static_cast<b2RevoluteJoint*>(src);
+	b2RevoluteJointDef def;
+	def.localAnchorA = j->GetLocalAnchorA();
+	def.localAnchorB = j->GetLocalAnchorB();
+	def.referenceAngle = j->GetReferenceAngle();
+	def.enableLimit = j->IsLimitEnabled();
+	def.lowerAngle = j->GetLowerLimit();
+	def.upperAngle = j->GetUpperLimit();
+	def.enableMotor = j->IsMotorEnabled();
+	def.motorSpeed = j->GetMotorSpeed();
+	def.maxMotorTorque = j->GetMaxMotorTorque();
+	def.bodyA = bodyA;
+	def.bodyB = bodyB;
+	def.collideConnected = src->GetCollideConnected();
+	return _world->CreateJoint(&def);
+      }
+    case e_prismaticJoint:
+      {
+	auto j = static_cast<b2PrismaticJoint*>(src);
+	b2PrismaticJointDef def;
+	def.localAnchorA = j->GetLocalAnchorA();
+	def.localAnchorB = j->GetLocalAnchorB();
+	def.localAxisA = j->GetLocalAxisA();
+	def.referenceAngle = j->GetReferenceAngle();
+	def.enableLimit = j->IsLimitEnabled();
+	def.lowerTranslation = j->GetLowerLimit();
+	def.upperTranslation = j->GetUpperLimit();
+	def.enableMotor = j->IsMotorEnabled();
+	def.maxMotorForce = j->GetMaxMotorForce();
+	def.motorSpeed = j->GetMotorSpeed();
+	def.bodyA = bodyA;
+	def.bodyB = bodyB;
+	def.collideConnected = src->GetCollideConnected();
+	return _world->CreateJoint(&def);
+      }
+    case e_weldJoint:
+      {
+	auto j = static_cast<b2WeldJoint*>(src);
+	b2WeldJointDef def;
+	def.localAnchorA = j->GetLocalAnchorA();
+	def.localAnchorB = j->GetLocalAnchorB();
+	def.referenceAngle = j->GetReferenceAngle();
+	def.stiffness = j->GetStiffness();
+	def.damping = j->GetDamping();
+	def.bodyA = bodyA;
+	def.bodyB = bodyB;
+	def.collideConnected = src->GetCollideConnected();
+	return _world->CreateJoint(&def);
+      }
+    case e_distanceJoint:
+      {
+	auto j = static_cast<b2DistanceJoint*>(src);
+	b2DistanceJointDef def;
+	def.localAnchorA = j->GetLocalAnchorA();
+	def.localAnchorB = j->GetLocalAnchorB();
+	def.length = j->GetLength();
+	def.minLength = j->GetMinLength();
+	def.maxLength = j->GetMaxLength();
+	def.stiffness = j->GetStiffness();
+	def.damping = j->GetDamping();
+	def.bodyA = bodyA;
+	def.bodyB = bodyB;
+	def.collideConnected = src->GetCollideConnected();
+	return _world->CreateJoint(&def);
+      }
+    case e_wheelJoint:
+      {
+	auto j = static_cast<b2WheelJoint*>(src);
+	b2WheelJointDef def;
+	def.localAnchorA = j->GetLocalAnchorA();
+	def.localAnchorB = j->GetLocalAnchorB();
+	def.localAxisA = j->GetLocalAxisA();
+	def.enableLimit = j->IsLimitEnabled();
+	def.lowerTranslation = j->GetLowerLimit();
+	def.upperTranslation = j->GetUpperLimit();
+	def.enableMotor = j->IsMotorEnabled();
+	def.maxMotorTorque = j->GetMaxMotorTorque();
+	def.motorSpeed = j->GetMotorSpeed();
+	def.stiffness = j->GetStiffness();
+	def.damping = j->GetDamping();
+	def.bodyA = bodyA;
+	def.bodyB = bodyB;
+	def.collideConnected = src->GetCollideConnected();
+	return _world->CreateJoint(&def);
+      }
+    default: // not supported joints (mouse, pulley, gear, friction, motor and rope joints)
+      {
+	assert(0 && "Joint type not supported by CloneMap");
+	return nullptr;
+      }
+    }
+  }
+} // namespace robox2d
@@ -0,0 +1,42 @@
+#ifndef ROBOX2D_CLONE_MAP_HPP
+#define ROBOX2D_CLONE_MAP_HPP
+
+#include <memory>
+#include <unordered_map>
+
+#include <box2d/box2d.h>
+
+namespace robox2d {
+
+  /**
+   * @brief CloneMap duplicates bodies (with their fixtures) and joints into another world and remembers the mapping.
+   *
+   * Bodies are cloned on demand together with the articulated structure they belong to (all the bodies and joints
+   * reachable through joints), so the actuators of a robot can be rebound with body() and joint().
+   * User data is not copied.
+   */
+  class CloneMap {
+  public:
+    CloneMap(std::shared_ptr<b2World> world) : _world(world) {}
+
+    /* World the clones are created in */
+    std::shared_ptr<b2World> world() const { return _world; }
+
+    /* Clone of src (created with its articulated structure if needed) */
+    b2Body* body(b2Body* src);
+    b2Joint* joint(b2Joint* src);
+
+    /* Clone all the bodies and joints of src, in the same order (so that snapshots are compatible) */
+    void clone_world(b2World& src);
+
+  protected:
+    b2Body* _clone_body(b2Body* src);
+    b2Joint* _clone_joint(b2Joint* src);
+
+    std::shared_ptr<b2World> _world;
+    std::unordered_map<b2Body*, b2Body*> _bodies;
+    std::unordered_map<b2Joint*, b2Joint*> _joints;
+  };
+} // namespace robox2d
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef ROBOX2D_CONTROL_BASE_CONTROLLER
 #define ROBOX2D_CONTROL_BASE_CONTROLLER
 
+#include <cassert>
 #include <memory>
 #include <vector>
 #include <Eigen/Core>
@@ -18,10 +19,43 @@ namespace robox2d {
       BaseController(size_t nb_dofs):_nb_dofs(nb_dofs){}
       virtual ~BaseController() {}
 
-      virtual Eigen::VectorXd commands(double t,robox2d::Robot* robot)=0;
+      /**
+       * @brief Write the commands of the controller in cmd (of size nb_dofs) without allocating.
+       *
+       * This is the method called by Robot::control_update. The default implementation calls commands(), for the
+       * controllers written before write_commands (they work, but allocate at every control update).
+       */
+      virtual void write_commands(double t, robox2d::Robot* robot, Eigen::Ref<Eigen::VectorXd> cmd)
+      {
+	static thread_local bool in_commands = false;
+	assert(!in_commands && "A controller must override write_commands (or commands)");
+	if (in_commands) {
+	  cmd.setZero();
+	  return;
+	}
+	in_commands = true;
+	cmd = commands(t, robot);
+	in_commands = false;
+      }
+
+      /* Allocating wrapper of write_commands (overridden by the older controllers, see write_commands) */
+      virtual Eigen::VectorXd commands(double t, robox2d::Robot* robot)
+      {
+	Eigen::VectorXd cmd(_nb_dofs);
+	write_commands(t, robot, cmd);
+	return cmd;
+      }
       //{
       //return Eigen::VectorXd::Ones(_nb_dofs)*sin(2.0*M_PI*t) *M_PI;
       //}
+
+      /* Internal state of the controller (used by Simu::snapshot/restore), stateless by default */
+      virtual size_t state_size() const {return 0;}
+      virtual void save_state(double* state) const {}
+      virtual void load_state(const double* state) {}
+
+      /* Copy of the controller used by Robot::clone (nullptr: the controller is stateless and can be shared) */
+      virtual std::shared_ptr<BaseController> clone() const {return nullptr;}
       
     protected:
       
@@ -33,7 +67,7 @@ namespace robox2d {
     public:
       ConstantPos(Eigen::VectorXd cmd): BaseController(cmd.size()), _cmd(cmd){}
       
-      Eigen::VectorXd commands(double t, robox2d::Robot* robot){ return _cmd;}
+      void write_commands(double t, robox2d::Robot* robot, Eigen::Ref<Eigen::VectorXd> cmd){ cmd = _cmd;}
     private:
       Eigen::VectorXd _cmd;
     };
@@ -0,0 +1,23 @@
+#ifndef ROBOX2D_CONTROL_BATCH_CONTROLLER
+#define ROBOX2D_CONTROL_BATCH_CONTROLLER
+
+namespace robox2d {
+  namespace control {
+
+    /**
+     * @brief Controller computing the commands of many robots at once (see Simu::set_batch_controller).
+     *
+     * update() is called once per control tick, after the sensors and before the controllers of the robots,
+     * which read their share of the result (see BatchedMLP and MLPSlot).
+     */
+    class BatchController {
+    public:
+      virtual ~BatchController() {}
+
+      virtual void update() = 0;
+    };
+
+  } // namespace control
+} // namespace robox2d
+
+#endif
@@ -0,0 +1,224 @@
+#include "mlp.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <random>
+
+#include "robox2d/robot.hpp"
+#include "robox2d/simu.hpp"
+
+namespace robox2d {
+  namespace control {
+
+    constexpr size_t MLPSlot::npos;
+
+    namespace {
+      // out = f(out + bias), column by column, in one pass after the product
+      template <typename F>
+      void bias_activation(Eigen::MatrixXf& out, const Eigen::VectorXf& bias, F f)
+      {
+	const Eigen::Index rows = out.rows();
+	const float* b = bias.data();
+	float* o = out.data();
+	for (Eigen::Index c = 0; c < out.cols(); c++, o += rows)
+	  for (Eigen::Index r = 0; r < rows; r++)
+	    o[r] = f(o[r] + b[r]);
+      }
+    }
+
+    // MLP
+
+    MLP::MLP(const std::vector<size_t>& sizes, Activation activation, Activation output_activation)
+    {
+      assert(sizes.size() >= 2 && "An MLP needs at least a number of inputs and a number of outputs");
+      for (size_t i = 1; i < sizes.size(); i++) {
+	Layer layer;
+	layer.weights = Eigen::MatrixXf::Zero(sizes[i], sizes[i - 1]);
+	layer.bias = Eigen::VectorXf::Zero(sizes[i]);
+	layer.activation = i + 1 < sizes.size() ? activation : output_activation;
+	_layers.push_back(layer);
+      }
+    }
+
+    size_t MLP::nb_parameters() const
+    {
+      size_t n = 0;
+      for (auto& layer : _layers)
+	n += layer.weights.size() + layer.bias.size();
+      return n;
+    }
+
+    void MLP::set_parameters(const float* parameters)
+    {
+      for (auto& layer : _layers) {
+	layer.weights = Eigen::Map<const Eigen::MatrixXf>(parameters, layer.weights.rows(), layer.weights.cols());
+	parameters += layer.weights.size();
+	layer.bias = Eigen::Map<const Eigen::VectorXf>(parameters, layer.bias.size());
+	parameters += layer.bias.size();
+      }
+    }
+
+    void MLP::get_parameters(float* parameters) const
+    {
+      for (auto& layer : _layers) {
+	Eigen::Map<Eigen::MatrixXf>(parameters, layer.weights.rows(), layer.weights.cols()) = layer.weights;
+	parameters += layer.weights.size();
+	Eigen::Map<Eigen::VectorXf>(parameters, layer.bias.size()) = layer.bias;
+	parameters += layer.bias.size();
+      }
+    }
+
+    void MLP::randomize(unsigned int seed)
+    {
+      std::mt19937 gen(seed);
+      for (auto& layer : _layers) {
+	float limit = std::sqrt(6.0f / (layer.weights.rows() + layer.weights.cols()));
+	std::uniform_real_distribution<float> dist(-limit, limit);
+	for (Eigen::Index i = 0; i < layer.weights.size(); i++)
+	  layer.weights.data()[i] = dist(gen);
+	layer.bias.setZero();
+      }
+    }
+
+    const Eigen::MatrixXf& MLP::forward(const Eigen::Ref<const Eigen::MatrixXf>& inputs, Workspace& workspace) const
+    {
+      assert(size_t(inputs.rows()) == nb_inputs() && "Wrong number of inputs");
+      workspace.outputs.resize(_layers.size());
+      for (size_t l = 0; l < _layers.size(); l++) {
+	const Layer& layer = _layers[l];
+	Eigen::MatrixXf& out = workspace.outputs[l];
+	out.resize(layer.weights.rows(), inputs.cols()); // no allocation when the size does not change
+	if (l == 0)
+	  out.noalias() = layer.weights * inputs;
+	else
+	  out.noalias() = layer.weights * workspace.outputs[l - 1];
+
+	switch (layer.activation) {
+	case Activation::Linear:
+	  bias_activation(out, layer.bias, [](float x) { return x; });
+	  break;
+	case Activation::Tanh:
+	  bias_activation(out, layer.bias, [](float x) { return std::tanh(x); });
+	  break;
+	case Activation::Relu:
+	  bias_activation(out, layer.bias, [](float x) { return x > 0.0f ? x : 0.0f; });
+	  break;
+	case Activation::Sigmoid:
+	  bias_activation(out, layer.bias, [](float x) { return 1.0f / (1.0f + std::exp(-x)); });
+	  break;
+	}
+      }
+      return workspace.outputs.back();
+    }
+
+    void sensor_observation(Robot& robot, Eigen::Ref<Eigen::VectorXf> input)
+    {
+      assert(input.size() == robot.observations().size() && "The observations of the robot do not match the inputs of the network");
+      input = robot.observations().cast<float>();
+    }
+
+    // MLPController
+
+    MLPController::MLPController(const std::shared_ptr<const MLP>& mlp, double scale, const observation_t& observation) :
+      BaseController(mlp->nb_outputs()),
+      _mlp(mlp),
+      _scale(scale),
+      _observation(observation),
+      _input(mlp->nb_inputs())
+    {
+    }
+
+    void MLPController::write_commands(double t, robox2d::Robot* robot, Eigen::Ref<Eigen::VectorXd> cmd)
+    {
+      _observation(*robot, _input);
+      const Eigen::MatrixXf& out = _mlp->forward(_input, _workspace);
+      cmd = _scale * out.col(0).cast<double>();
+    }
+
+    // MLPSlot
+
+    void MLPSlot::write_commands(double t, robox2d::Robot* robot, Eigen::Ref<Eigen::VectorXd> cmd)
+    {
+      _batch->_write_commands(_column, cmd);
+    }
+
+    // BatchedMLP
+
+    BatchedMLP::BatchedMLP(const std::shared_ptr<const MLP>& mlp, double scale, const observation_t& observation) :
+      _mlp(mlp),
+      _scale(scale),
+      _observation(observation)
+    {
+    }
+
+    std::shared_ptr<MLPSlot> BatchedMLP::add_robot(const std::shared_ptr<Robot>& robot)
+    {
+      assert(robot->nb_dofs() == _mlp->nb_outputs() && "The actuators of the robot do not match the outputs of the network");
+      std::shared_ptr<MLPSlot> slot;
+      for (auto& ctrl : robot->controllers()) {
+	auto s = std::dynamic_pointer_cast<MLPSlot>(ctrl);
+	if (s && s->batch() == this)
+	  slot = s;
+      }
+      if (!slot) {
+	slot = std::make_shared<MLPSlot>(this, _mlp->nb_outputs());
+	robot->add_controller(slot);
+      }
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      // already in the batch (e.g. added by the factory of a SimuPool, then by add_robots): one column per robot
+      for (auto& e : _entries)
+	if (e.robot.lock() == robot)
+	  return slot;
+      _entries.push_back({robot, slot});
+      return slot;
+    }
+
+    void BatchedMLP::add_robots(const Simu& simu)
+    {
+      for (auto& robot : simu.robots())
+	add_robot(robot);
+    }
+
+    void BatchedMLP::update()
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+
+      // drop the robots that no longer exist, the others keep their order
+      size_t n = 0;
+      for (size_t i = 0; i < _entries.size(); i++) {
+	if (_entries[i].robot.expired()) {
+	  _entries[i].slot->_column = MLPSlot::npos;
+	  continue;
+	}
+	if (n != i)
+	  _entries[n] = std::move(_entries[i]);
+	_entries[n].slot->_column = n;
+	n++;
+      }
+      _entries.resize(n);
+
+      // gather the observations, one column per robot
+      _inputs.resize(_mlp->nb_inputs(), n);
+      for (size_t i = 0; i < n; i++) {
+	auto robot = _entries[i].robot.lock();
+	_observation(*robot, _inputs.col(i));
+      }
+
+      // the last buffer of the workspace takes the memory of the previous outputs: no copy, no allocation
+      _mlp->forward(_inputs, _workspace);
+      _outputs.swap(_workspace.outputs.back());
+    }
+
+    void BatchedMLP::_write_commands(size_t column, Eigen::Ref<Eigen::VectorXd> cmd) const
+    {
+      // robots added since the last update have no column yet
+      if (column >= size_t(_outputs.cols())) {
+	cmd.setZero();
+	return;
+      }
+      cmd = _scale * _outputs.col(column).cast<double>();
+    }
+
+  } // namespace control
+} // namespace robox2d
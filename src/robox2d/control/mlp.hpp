@@ -0,0 +1,184 @@
+#ifndef ROBOX2D_CONTROL_MLP
+#define ROBOX2D_CONTROL_MLP
+
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "robox2d/robot.hpp"
+#include "batch_controller.hpp"
+
+namespace robox2d {
+  class Simu;
+
+  namespace control {
+
+    enum class Activation { Linear, Tanh, Relu, Sigmoid };
+
+    /**
+     * @brief Multilayer perceptron in float32, evaluated on a batch of inputs (one sample per column).
+     *
+     * Each layer is one matrix product over the whole batch, followed by a single pass adding the bias and
+     * applying the activation. The buffers of the evaluation are kept in a Workspace (one per thread), so the
+     * network itself can be shared.
+     */
+    class MLP {
+    public:
+      struct Layer {
+	Eigen::MatrixXf weights; // outputs x inputs
+	Eigen::VectorXf bias;
+	Activation activation;
+      };
+
+      /* Outputs of the layers of the last forward pass (reused: no allocation for a constant batch size) */
+      struct Workspace {
+	std::vector<Eigen::MatrixXf> outputs;
+      };
+
+      /**
+       * @brief Construct a network with zero weights.
+       *
+       * @param  sizes number of inputs, sizes of the hidden layers, number of outputs.
+       * @param  activation activation of the hidden layers.
+       * @param  output_activation activation of the output layer.
+       */
+      MLP(const std::vector<size_t>& sizes, Activation activation = Activation::Tanh, Activation output_activation = Activation::Tanh);
+
+      size_t nb_inputs() const { return _layers.front().weights.cols(); }
+      size_t nb_outputs() const { return _layers.back().weights.rows(); }
+      size_t nb_layers() const { return _layers.size(); }
+      Layer& layer(size_t index) { return _layers[index]; }
+      const Layer& layer(size_t index) const { return _layers[index]; }
+
+      /* Weights then bias of each layer, column-major */
+      size_t nb_parameters() const;
+      void set_parameters(const float* parameters);
+      void get_parameters(float* parameters) const;
+
+      /* Uniform Xavier initialization of the weights, zero bias */
+      void randomize(unsigned int seed);
+
+      /* Evaluate the network on the columns of inputs; returns the outputs (a buffer of workspace) */
+      const Eigen::MatrixXf& forward(const Eigen::Ref<const Eigen::MatrixXf>& inputs, Workspace& workspace) const;
+
+    protected:
+      std::vector<Layer> _layers;
+    };
+
+    /* Write the input of the network for robot (of size MLP::nb_inputs) */
+    using observation_t = std::function<void(Robot& robot, Eigen::Ref<Eigen::VectorXf> input)>;
+    /* Measures of the sensors of the robot (Robot::observations) */
+    void sensor_observation(Robot& robot, Eigen::Ref<Eigen::VectorXf> input);
+
+    /**
+     * @brief Neural controller of one robot: commands = scale * mlp(observation).
+     */
+    class MLPController : public BaseController {
+    public:
+      MLPController(const std::shared_ptr<const MLP>& mlp, double scale = 1.0, const observation_t& observation = sensor_observation);
+
+      void write_commands(double t, robox2d::Robot* robot, Eigen::Ref<Eigen::VectorXd> cmd) override;
+
+      /* Copies have their own buffers (the network is shared) */
+      std::shared_ptr<BaseController> clone() const override { return std::make_shared<MLPController>(*this); }
+
+    protected:
+      std::shared_ptr<const MLP> _mlp;
+      double _scale;
+      observation_t _observation;
+      Eigen::VectorXf _input;
+      MLP::Workspace _workspace;
+    };
+
+    class BatchedMLP;
+
+    /**
+     * @brief Controller of a robot of a BatchedMLP: writes the column of the robot in the outputs of the batch.
+     */
+    class MLPSlot : public BaseController {
+    public:
+      static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+      MLPSlot(const BatchedMLP* batch, size_t nb_dofs) : BaseController(nb_dofs), _batch(batch) {}
+
+      void write_commands(double t, robox2d::Robot* robot, Eigen::Ref<Eigen::VectorXd> cmd) override;
+
+      /* Copies are not in the batch (zero commands) until their robot is added with BatchedMLP::add_robot */
+      std::shared_ptr<BaseController> clone() const override { return std::make_shared<MLPSlot>(_batch, _nb_dofs); }
+
+      const BatchedMLP* batch() const { return _batch; }
+      /* Column of the robot in the batch (npos if it is not in the batch) */
+      size_t column() const { return _column; }
+
+    protected:
+      friend class BatchedMLP;
+
+      const BatchedMLP* _batch;
+      size_t _column = npos;
+    };
+
+    /**
+     * @brief One network evaluated for many robots at once.
+     *
+     * At each update, the observations of all the robots of the batch are gathered in one matrix (one column
+     * per robot), the network is evaluated on it (one matrix product per layer) and the controller of each
+     * robot (an MLPSlot) reads its column of the outputs at its control update. Robots that no longer exist
+     * are dropped from the batch at the next update.
+     *
+     * The batch can serve the robots of one simu (Simu::set_batch_controller) or of all the environments of a
+     * SimuPool (SimuPool::set_batch_controller, which keeps the simus in lockstep on their control ticks). The
+     * batch must outlive the controllers of its robots.
+     */
+    class BatchedMLP : public BatchController {
+    public:
+      BatchedMLP(const std::shared_ptr<const MLP>& mlp, double scale = 1.0, const observation_t& observation = sensor_observation);
+
+      /**
+       * @brief Add a robot to the batch and return its controller.
+       *
+       * The controller is added to the robot, or reused if the robot already has one for this batch (a copy
+       * made by Robot::clone). A robot already in the batch is not added again. Thread-safe (robots can be added
+       * from the factory of a SimuPool).
+       */
+      std::shared_ptr<MLPSlot> add_robot(const std::shared_ptr<Robot>& robot);
+      /* Add all the robots of simu */
+      void add_robots(const Simu& simu);
+
+      void update() override;
+
+      /* Robots in the batch at the last update */
+      size_t nb_robots() const { return _outputs.cols(); }
+      const MLP& mlp() const { return *_mlp; }
+      /* One column per robot, in the order of the columns of the slots */
+      const Eigen::MatrixXf& inputs() const { return _inputs; }
+      const Eigen::MatrixXf& outputs() const { return _outputs; }
+
+    protected:
+      friend class MLPSlot;
+
+      struct Entry {
+	std::weak_ptr<Robot> robot;
+	std::shared_ptr<MLPSlot> slot;
+      };
+
+      void _write_commands(size_t column, Eigen::Ref<Eigen::VectorXd> cmd) const;
+
+      std::shared_ptr<const MLP> _mlp;
+      double _scale;
+      observation_t _observation;
+
+      std::mutex _mutex; // protects _entries
+      std::vector<Entry> _entries;
+      Eigen::MatrixXf _inputs;
+      Eigen::MatrixXf _outputs;
+      MLP::Workspace _workspace;
+    };
+
+  } // namespace control
+} // namespace robox2d
+
+#endif
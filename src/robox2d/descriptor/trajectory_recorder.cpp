@@ -0,0 +1,77 @@
+#include "trajectory_recorder.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "robox2d/robot.hpp"
+#include "robox2d/simu.hpp"
+
+namespace robox2d {
+    namespace descriptor {
+        TrajectoryRecorder::TrajectoryRecorder(const std::string& filename, size_t desc_dump, size_t chunk_frames) :
+            BaseDescriptor(desc_dump), _filename(filename), _chunk_frames(chunk_frames) {}
+
+        void TrajectoryRecorder::operator()()
+        {
+            if (!_writer)
+                _init();
+
+            // same body list as when the recorder started: copy the columns of the world state
+            const WorldState& ws = _simu->world_state();
+            if (ws.version == _state_version && ws.size() == _bodies.size()) {
+                std::copy(ws.x.begin(), ws.x.end(), _x.begin());
+                std::copy(ws.y.begin(), ws.y.end(), _y.begin());
+                std::copy(ws.angle.begin(), ws.angle.end(), _angle.begin());
+            }
+            else {
+                for (size_t i = 0; i < _bodies.size(); i++) {
+                    const b2Transform& xf = _bodies[i]->GetTransform();
+                    _x[i] = xf.p.x;
+                    _y[i] = xf.p.y;
+                    _angle[i] = _bodies[i]->GetAngle();
+                }
+            }
+            for (size_t i = 0; i < _joints.size(); i++)
+                _joint_positions[i] = trajectory::joint_position(_joints[i]);
+
+            // commands of the robots, in the order of Simu::robots (padded with 0 if a robot has no command yet)
+            size_t k = 0;
+            for (auto& robot : _simu->robots()) {
+                const Eigen::VectorXd& commands = robot->commands();
+                for (size_t j = 0; j < robot->nb_dofs() && k < _inputs.size(); j++, k++)
+                    _inputs[k] = j < size_t(commands.size()) ? commands(j) : 0.0f;
+            }
+
+            _writer->write(_simu->time(), _x.data(), _y.data(), _angle.data(), _joint_positions.data(), _inputs.data());
+        }
+
+        void TrajectoryRecorder::close()
+        {
+            if (_writer)
+                _writer->close();
+        }
+
+        void TrajectoryRecorder::_init()
+        {
+            auto world = _simu->world();
+            _state_version = _simu->world_state().version;
+            for (b2Body* body = world->GetBodyList(); body; body = body->GetNext())
+                _bodies.push_back(body);
+            for (b2Joint* joint = world->GetJointList(); joint; joint = joint->GetNext())
+                _joints.push_back(joint);
+            size_t nb_inputs = 0;
+            for (auto& robot : _simu->robots())
+                nb_inputs += robot->nb_dofs();
+
+            _x.resize(_bodies.size());
+            _y.resize(_bodies.size());
+            _angle.resize(_bodies.size());
+            _joint_positions.resize(_joints.size());
+            _inputs.assign(nb_inputs, 0.0f);
+
+            _writer.reset(new trajectory::Writer(_filename, _bodies.size(), _joints.size(), nb_inputs, _chunk_frames));
+            if (!_writer->good())
+                std::cout << "Warning: cannot write the trajectory file " << _filename << std::endl;
+        }
+    } // namespace descriptor
+} // namespace robox2d
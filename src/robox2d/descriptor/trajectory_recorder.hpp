@@ -0,0 +1,48 @@
+#ifndef ROBOX2D_DESCRIPTOR_TRAJECTORY_RECORDER_HPP
+#define ROBOX2D_DESCRIPTOR_TRAJECTORY_RECORDER_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "robox2d/descriptor/base_descriptor.hpp"
+#include "robox2d/trajectory.hpp"
+
+namespace robox2d {
+    namespace descriptor {
+
+        /**
+         * @brief Records the simu in a binary trajectory file (see trajectory::Writer), right after the world steps.
+         *
+         * Each frame holds the time, the pose of every body, the position of every joint and the commands of every
+         * robot. The bodies and joints are the ones of the world at the first recorded step (in the order of the
+         * Box2D lists, which is the order expected by trajectory::Reader::apply): the structure of the world must not
+         * change while recording. The file is complete once close() is called or the recorder is destroyed.
+         */
+        struct TrajectoryRecorder : public BaseDescriptor {
+        public:
+            TrajectoryRecorder(const std::string& filename, size_t desc_dump = 1, size_t chunk_frames = 256);
+
+            void operator()() override;
+
+            void close();
+
+            const std::string& filename() const { return _filename; }
+            size_t nb_frames() const { return _writer ? _writer->nb_frames() : 0; }
+
+        protected:
+            void _init();
+
+            std::string _filename;
+            size_t _chunk_frames;
+            std::unique_ptr<trajectory::Writer> _writer;
+
+            std::vector<b2Body*> _bodies;
+            size_t _state_version = 0; // version of the world state when the bodies were listed
+            std::vector<b2Joint*> _joints;
+            std::vector<float> _x, _y, _angle, _joint_positions, _inputs;
+        };
+    } // namespace descriptor
+} // namespace robox2d
+
+#endif
@@ -0,0 +1,29 @@
+#include "destruction_listener.hpp"
+
+#include <algorithm>
+
+namespace robox2d {
+
+  void DestructionListeners::add(b2DestructionListener* listener)
+  {
+    if (std::find(_listeners.begin(), _listeners.end(), listener) == _listeners.end())
+      _listeners.push_back(listener);
+  }
+
+  void DestructionListeners::remove(b2DestructionListener* listener)
+  {
+    _listeners.erase(std::remove(_listeners.begin(), _listeners.end(), listener), _listeners.end());
+  }
+
+  void DestructionListeners::SayGoodbye(b2Joint* joint)
+  {
+    for (auto listener : _listeners)
+      listener->SayGoodbye(joint);
+  }
+
+  void DestructionListeners::SayGoodbye(b2Fixture* fixture)
+  {
+    for (auto listener : _listeners)
+      listener->SayGoodbye(fixture);
+  }
+} // namespace robox2d
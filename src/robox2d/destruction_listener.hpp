@@ -0,0 +1,31 @@
+#ifndef ROBOX2D_DESTRUCTION_LISTENER_HPP
+#define ROBOX2D_DESTRUCTION_LISTENER_HPP
+
+#include <vector>
+
+#include <box2d/box2d.h>
+
+namespace robox2d {
+
+  /**
+   * @brief Destruction listener forwarding to several listeners.
+   *
+   * A b2World has a single destruction listener slot, without getter: the Simu installs one of these on its world
+   * (see Simu::destruction_listeners) and the components that need to know about destroyed joints and fixtures
+   * (e.g. gui::InstanceBuilder) register with it instead of taking the slot.
+   */
+  class DestructionListeners : public b2DestructionListener {
+  public:
+    void add(b2DestructionListener* listener);
+    void remove(b2DestructionListener* listener);
+    size_t size() const { return _listeners.size(); }
+
+    void SayGoodbye(b2Joint* joint) override;
+    void SayGoodbye(b2Fixture* fixture) override;
+
+  protected:
+    std::vector<b2DestructionListener*> _listeners;
+  };
+} // namespace robox2d
+
+#endif
@@ -0,0 +1,386 @@
+#include "instance_builder.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+namespace robox2d {
+  namespace gui {
+
+    constexpr InstanceBuilder::handle_t InstanceBuilder::invalid_handle;
+
+    InstanceBuilder::InstanceBuilder(std::shared_ptr<b2World> world, DestructionListeners* listeners)
+    {
+      _listener.builder = this;
+      _query.builder = this;
+      set_world(world, listeners);
+    }
+
+    InstanceBuilder::~InstanceBuilder()
+    {
+      if (_listeners)
+	_listeners->remove(&_listener);
+    }
+
+    void InstanceBuilder::set_world(std::shared_ptr<b2World> world, DestructionListeners* listeners)
+    {
+      if (_listeners)
+	_listeners->remove(&_listener);
+      _world = world;
+      _listeners = world ? listeners : nullptr;
+      if (_listeners)
+	_listeners->add(&_listener);
+      rebuild();
+    }
+
+    void InstanceBuilder::rebuild()
+    {
+      clear();
+      sync();
+    }
+
+    void InstanceBuilder::clear()
+    {
+      for (auto& shape : _shapes)
+	shape.clear();
+      _handles.clear();
+      _free_handles.clear();
+      _fixture_handles.clear();
+      _nb_bodies = -1;
+      _nb_proxies = -1;
+    }
+
+    void InstanceBuilder::sync()
+    {
+      if (!_world)
+	return;
+      // new bodies and fixtures change these counts; a body destroyed and another one created (maybe at the
+      // same address) in between are seen through the removal of the fixtures of the destroyed one
+      if (_world->GetBodyCount() == _nb_bodies && _world->GetProxyCount() == _nb_proxies && !_removed)
+	return;
+      for (b2Body* body = _world->GetBodyList(); body; body = body->GetNext())
+	add_body(body); // the fixtures already registered are skipped
+      _nb_bodies = _world->GetBodyCount();
+      _nb_proxies = _world->GetProxyCount();
+      _removed = false;
+    }
+
+    size_t InstanceBuilder::size() const
+    {
+      size_t n = 0;
+      for (auto& shape : _shapes)
+	n += shape.fixtures.size();
+      return n;
+    }
+
+    InstanceBuilder::handle_t InstanceBuilder::add_fixture(b2Fixture* fixture)
+    {
+      auto it = _fixture_handles.find(fixture);
+      if (it != _fixture_handles.end())
+	return it->second;
+
+      Shape shape;
+      float lx, ly, angle, hx, hy;
+      switch (fixture->GetShape()->GetType())
+	{
+	case b2Shape::e_circle:
+	  {
+	    b2CircleShape* circle = static_cast<b2CircleShape*>(fixture->GetShape());
+	    shape = Circle;
+	    lx = circle->m_p.x;
+	    ly = circle->m_p.y;
+	    angle = 0.0f;
+	    hx = hy = circle->m_radius;
+	    break;
+	  }
+	case b2Shape::e_polygon: // boxes (more advanced polygons not supported yet)
+	  {
+	    b2PolygonShape* poly = static_cast<b2PolygonShape*>(fixture->GetShape());
+	    auto v = poly->m_vertices;
+	    b2Vec2 center = 0.5f * (v[2] + v[0]);
+	    b2Vec2 edge = v[1] - v[0];
+	    shape = Box;
+	    lx = center.x;
+	    ly = center.y;
+	    angle = std::atan2(edge.y, edge.x);
+	    hx = edge.Length() / 2;
+	    hy = (v[2] - v[1]).Length() / 2;
+	    break;
+	  }
+	default: // not supported shapes (remembered, so the warning is printed once)
+	  {
+	    std::cout << "Warning Shape Type not supported" << std::endl;
+	    _fixture_handles[fixture] = invalid_handle;
+	    return invalid_handle;
+	  }
+	}
+
+      handle_t handle;
+      if (_free_handles.empty()) {
+	handle = _handles.size();
+	_handles.push_back(HandleData());
+      }
+      else {
+	handle = _free_handles.back();
+	_free_handles.pop_back();
+      }
+      _handles[handle] = {fixture, shape, _shapes[shape].fixtures.size()};
+      _fixture_handles[fixture] = handle;
+      _shapes[shape].push_back(fixture, handle, lx, ly, angle, hx, hy, default_color(shape));
+      _state_indices_valid = false;
+      return handle;
+    }
+
+    void InstanceBuilder::add_body(b2Body* body)
+    {
+      for (b2Fixture* fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext())
+	add_fixture(fixture);
+    }
+
+    void InstanceBuilder::remove_fixture(b2Fixture* fixture)
+    {
+      auto it = _fixture_handles.find(fixture);
+      if (it == _fixture_handles.end())
+	return;
+      handle_t handle = it->second;
+      _fixture_handles.erase(it);
+      _removed = true;
+      if (handle == invalid_handle)
+	return;
+
+      ShapeArrays& arrays = _shapes[_handles[handle].shape];
+      size_t index = _handles[handle].index;
+      arrays.remove(index);
+      if (index < arrays.handles.size())
+	_handles[arrays.handles[index]].index = index; // the last fixture took the place of the removed one
+
+      _handles[handle] = {nullptr, Box, 0};
+      _free_handles.push_back(handle);
+    }
+
+    void InstanceBuilder::remove_body(b2Body* body)
+    {
+      for (b2Fixture* fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext())
+	remove_fixture(fixture);
+    }
+
+    InstanceBuilder::handle_t InstanceBuilder::handle(b2Fixture* fixture) const
+    {
+      auto it = _fixture_handles.find(fixture);
+      return it == _fixture_handles.end() ? invalid_handle : it->second;
+    }
+
+    void InstanceBuilder::build()
+    {
+      sync();
+
+      const WorldState* state = _state_cache ? &_state_cache->get() : nullptr;
+      if (state && (!_state_indices_valid || _state_version != state->version)) {
+	for (auto& a : _shapes)
+	  for (size_t i = 0; i < a.bodies.size(); i++)
+	    a.body_index[i] = _state_cache->index(a.bodies[i]);
+	_state_version = state->version;
+	_state_indices_valid = true;
+      }
+
+      if (_follow)
+	_view_center = _follow->GetWorldCenter();
+
+      if (!_culling || !_world) {
+	for (auto& a : _shapes)
+	  a.build(true, state);
+	return;
+      }
+
+      // visible fixtures, from the broadphase
+      for (auto& a : _shapes)
+	a.visible.clear();
+      b2Vec2 half_size = view_half_size();
+      b2AABB aabb;
+      aabb.lowerBound = _view_center - half_size;
+      aabb.upperBound = _view_center + half_size;
+      _world->QueryAABB(&_query, aabb);
+      for (auto& a : _shapes)
+	a.build(false, state);
+    }
+
+    void InstanceBuilder::set_view(const b2Vec2& center, const b2Vec2& half_size)
+    {
+      _view_center = center;
+      _view_half_size = half_size;
+    }
+
+    b2Vec2 InstanceBuilder::view_half_size() const
+    {
+      // same as the Extend aspect ratio policy of the camera
+      if (_aspect_ratio * _view_half_size.y > _view_half_size.x)
+	return {_aspect_ratio * _view_half_size.y, _view_half_size.y};
+      return {_view_half_size.x, _view_half_size.x / _aspect_ratio};
+    }
+
+    void InstanceBuilder::copy_to(FrameInstances& frame) const
+    {
+      // assign() keeps the capacity of the destination
+      frame.boxes.assign(_shapes[Box].instances.begin(), _shapes[Box].instances.end());
+      frame.circles.assign(_shapes[Circle].instances.begin(), _shapes[Circle].instances.end());
+      frame.view_center = _view_center;
+      frame.view_half_size = view_half_size();
+    }
+
+    std::array<float, 3> InstanceBuilder::default_color(Shape shape)
+    {
+      if (shape == Circle)
+	return {{0xea / 255.0f, 0xc9 / 255.0f, 0xa5 / 255.0f}};
+      return {{0xa5 / 255.0f, 0xc9 / 255.0f, 0xea / 255.0f}};
+    }
+
+    bool InstanceBuilder::QueryCallback::ReportFixture(b2Fixture* fixture)
+    {
+      auto it = builder->_fixture_handles.find(fixture);
+      if (it != builder->_fixture_handles.end() && it->second != invalid_handle) {
+	const HandleData& handle = builder->_handles[it->second];
+	builder->_shapes[handle.shape].visible.push_back(handle.index);
+      }
+      return true;
+    }
+
+    void InstanceBuilder::DestructionListener::SayGoodbye(b2Joint* joint)
+    {
+    }
+
+    void InstanceBuilder::DestructionListener::SayGoodbye(b2Fixture* fixture)
+    {
+      // only called when the body of the fixture is destroyed
+      builder->remove_fixture(fixture);
+      if (builder->_follow == fixture->GetBody())
+	builder->_follow = nullptr;
+    }
+
+    void InstanceBuilder::ShapeArrays::build(bool all, const WorldState* state)
+    {
+      const size_t n = all ? fixtures.size() : visible.size();
+      x.resize(n);
+      y.resize(n);
+      c.resize(n);
+      s.resize(n);
+      instances.resize(n);
+
+      // gather the body transforms (the only pass following pointers, or reading the world state)
+      for (size_t k = 0; k < n; k++) {
+	size_t i = all ? k : visible[k];
+	size_t j = state ? body_index[i] : WorldStateCache::npos;
+	if (j != WorldStateCache::npos) {
+	  x[k] = state->x[j];
+	  y[k] = state->y[j];
+	  c[k] = state->c[j];
+	  s[k] = state->s[j];
+	  continue;
+	}
+	const b2Transform& xf = bodies[i]->GetTransform();
+	x[k] = xf.p.x;
+	y[k] = xf.p.y;
+	c[k] = xf.q.c;
+	s[k] = xf.q.s;
+      }
+
+      if (all)
+	compute<false>(n);
+      else
+	compute<true>(n);
+    }
+
+    template <bool Culled>
+    void InstanceBuilder::ShapeArrays::compute(size_t n)
+    {
+      // instance = translation * rotation * scaling, on contiguous arrays
+      const size_t* index = visible.data();
+      const float* lx = local_x.data();
+      const float* ly = local_y.data();
+      const float* lc = local_c.data();
+      const float* ls = local_s.data();
+      const float* hx = half_x.data();
+      const float* hy = half_y.data();
+      const std::array<float, 3>* color = colors.data();
+      Instance* out = instances.data();
+      for (size_t k = 0; k < n; k++) {
+	const size_t i = Culled ? index[k] : k;
+	float rc = c[k] * lc[i] - s[k] * ls[i];
+	float rs = s[k] * lc[i] + c[k] * ls[i];
+	float* m = out[k].transformation;
+	m[0] = rc * hx[i];
+	m[1] = rs * hx[i];
+	m[2] = 0.0f;
+	m[3] = -rs * hy[i];
+	m[4] = rc * hy[i];
+	m[5] = 0.0f;
+	m[6] = x[k] + c[k] * lx[i] - s[k] * ly[i];
+	m[7] = y[k] + s[k] * lx[i] + c[k] * ly[i];
+	m[8] = 1.0f;
+	out[k].color[0] = color[i][0];
+	out[k].color[1] = color[i][1];
+	out[k].color[2] = color[i][2];
+      }
+    }
+
+    void InstanceBuilder::ShapeArrays::push_back(b2Fixture* fixture, handle_t handle, float lx, float ly, float angle, float hx, float hy, const std::array<float, 3>& color)
+    {
+      fixtures.push_back(fixture);
+      bodies.push_back(fixture->GetBody());
+      body_index.push_back(WorldStateCache::npos);
+      handles.push_back(handle);
+      colors.push_back(color);
+      local_x.push_back(lx);
+      local_y.push_back(ly);
+      local_c.push_back(std::cos(angle));
+      local_s.push_back(std::sin(angle));
+      half_x.push_back(hx);
+      half_y.push_back(hy);
+    }
+
+    namespace {
+      template <typename T>
+      void swap_remove(std::vector<T>& v, size_t index)
+      {
+	v[index] = v.back();
+	v.pop_back();
+      }
+    }
+
+    void InstanceBuilder::ShapeArrays::remove(size_t index)
+    {
+      assert(index < fixtures.size() && "Fixture index out of bounds");
+      swap_remove(fixtures, index);
+      swap_remove(bodies, index);
+      swap_remove(body_index, index);
+      swap_remove(handles, index);
+      swap_remove(colors, index);
+      swap_remove(local_x, index);
+      swap_remove(local_y, index);
+      swap_remove(local_c, index);
+      swap_remove(local_s, index);
+      swap_remove(half_x, index);
+      swap_remove(half_y, index);
+    }
+
+    void InstanceBuilder::ShapeArrays::clear()
+    {
+      fixtures.clear();
+      bodies.clear();
+      body_index.clear();
+      handles.clear();
+      colors.clear();
+      local_x.clear();
+      local_y.clear();
+      local_c.clear();
+      local_s.clear();
+      half_x.clear();
+      half_y.clear();
+      visible.clear();
+      x.clear();
+      y.clear();
+      c.clear();
+      s.clear();
+      instances.clear();
+    }
+  } // namespace gui
+} // namespace robox2d
@@ -0,0 +1,206 @@
+#ifndef ROBOX2D_GUI_INSTANCE_BUILDER_HPP
+#define ROBOX2D_GUI_INSTANCE_BUILDER_HPP
+
+#include <array>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <box2d/box2d.h>
+
+#include "robox2d/destruction_listener.hpp"
+#include "robox2d/world_state.hpp"
+
+namespace robox2d {
+  namespace gui {
+
+    /**
+     * @brief Instance of a shape mesh: 3x3 column-major transformation and RGB color.
+     *
+     * Same memory layout as the instance data of the Magnum renderer (Matrix3 + Color3), so the arrays can be
+     * uploaded to the GPU as they are.
+     */
+    struct Instance {
+      float transformation[9];
+      float color[3];
+    };
+
+    /**
+     * @brief Instances of one frame with the view they were built for (see InstanceBuilder::copy_to).
+     */
+    struct FrameInstances {
+      std::vector<Instance> boxes;
+      std::vector<Instance> circles;
+      b2Vec2 view_center = {0.0f, 0.0f};
+      b2Vec2 view_half_size = {1.0f, 1.0f};
+      size_t frame = 0;
+    };
+
+    /**
+     * @brief Builds the instances of all the fixtures of a world, without any scene graph nor GL call.
+     *
+     * Fixtures are kept in flat arrays, one set of arrays per shape type. build() reads the transforms of the
+     * bodies in a first pass, then computes all the instance matrices in a second pass over contiguous arrays.
+     *
+     * The builder follows the world incrementally: bodies and fixtures created after set_world are registered by
+     * sync() (called by build(); the world is scanned again only when its number of bodies or of broadphase
+     * proxies changed, or after a removal), and the fixtures of destroyed bodies are removed through the
+     * destruction listeners of the simu (see Simu::destruction_listeners). Each registered fixture gets a handle
+     * that stays valid until the fixture is removed; the user data of the fixtures is left untouched.
+     *
+     * Not covered automatically: fixtures destroyed with b2Body::DestroyFixture (call remove_fixture before), and
+     * without listeners, destroyed bodies (call remove_body before).
+     *
+     * The builder also holds the view of the renderer (a rectangle of the world, that can follow a body). With
+     * culling enabled (default), only the fixtures overlapping the view (found with b2World::QueryAABB) get an
+     * instance.
+     *
+     * With a state cache (see Simu::world_state_cache), the transforms of the bodies are read from the world
+     * state shared with the controllers and descriptors instead of the bodies.
+     */
+    class InstanceBuilder {
+    public:
+      enum Shape { Box = 0, Circle, NbShapes };
+      using handle_t = size_t;
+      static constexpr handle_t invalid_handle = std::numeric_limits<handle_t>::max();
+
+      InstanceBuilder(std::shared_ptr<b2World> world = nullptr, DestructionListeners* listeners = nullptr);
+      ~InstanceBuilder();
+
+      InstanceBuilder(const InstanceBuilder&) = delete;
+      InstanceBuilder& operator=(const InstanceBuilder&) = delete;
+
+      /* Set the world (and the destruction listeners of its simu) and register all the fixtures */
+      void set_world(std::shared_ptr<b2World> world, DestructionListeners* listeners = nullptr);
+      const std::shared_ptr<b2World>& world() const { return _world; }
+
+      /* Read the transforms of the bodies from cache (of the same world; nullptr to read the bodies) */
+      void set_state_cache(const WorldStateCache* cache) { _state_cache = cache; _state_indices_valid = false; }
+      const WorldStateCache* state_cache() const { return _state_cache; }
+
+      /* Forget all the fixtures and register the ones of the world again */
+      void rebuild();
+      void clear();
+
+      /* Register the bodies and fixtures created since the last call (cheap when there is none) */
+      void sync();
+
+      /* Register one fixture (only circles and boxes are supported); return invalid_handle if it is not supported */
+      handle_t add_fixture(b2Fixture* fixture);
+      void add_body(b2Body* body);
+      void remove_fixture(b2Fixture* fixture);
+      void remove_body(b2Body* body);
+
+      handle_t handle(b2Fixture* fixture) const;
+      b2Fixture* fixture(handle_t handle) const { return _handles[handle].fixture; }
+      Shape shape(handle_t handle) const { return _handles[handle].shape; }
+      /* Position of the fixture among the fixtures of its shape (changes when fixtures are removed) */
+      size_t index(handle_t handle) const { return _handles[handle].index; }
+
+      /* Compute the instances of all the registered fixtures (the visible ones with culling) */
+      void build();
+
+      // View of the renderer
+
+      /* Visible rectangle: center and half size (extended to match the aspect ratio) */
+      void set_view(const b2Vec2& center, const b2Vec2& half_size);
+      void set_view_center(const b2Vec2& center) { _view_center = center; }
+      b2Vec2 view_center() const { return _view_center; }
+      b2Vec2 view_half_size() const;
+      /* Width / height of the viewport */
+      void set_aspect_ratio(float aspect_ratio) { _aspect_ratio = aspect_ratio; }
+
+      /* Center the view on a body at each build (nullptr to stop) */
+      void follow(b2Body* body) { _follow = body; }
+      b2Body* followed() const { return _follow; }
+
+      void set_culling(bool enable) { _culling = enable; }
+      bool culling() const { return _culling; }
+
+      /* Instances computed by the last build (in the order of the fixtures without culling) */
+      std::vector<Instance>& instances(Shape shape) { return _shapes[shape].instances; }
+      const std::vector<Instance>& instances(Shape shape) const { return _shapes[shape].instances; }
+      /* Number of registered fixtures */
+      size_t size(Shape shape) const { return _shapes[shape].fixtures.size(); }
+      size_t size() const;
+
+      /* Copy the instances of the last build and the view (reuses the memory of frame) */
+      void copy_to(FrameInstances& frame) const;
+
+      /* Colors of the renderer: 0xa5c9ea for boxes, 0xeac9a5 for circles */
+      static std::array<float, 3> default_color(Shape shape);
+
+    protected:
+      struct ShapeArrays {
+	std::vector<b2Fixture*> fixtures;
+	std::vector<b2Body*> bodies;
+	std::vector<handle_t> handles;
+	std::vector<std::array<float, 3>> colors;
+	// shape in the body frame: center, rotation and half size
+	std::vector<float> local_x, local_y, local_c, local_s, half_x, half_y;
+	// index of the bodies in the world state (WorldStateCache::npos when not resolved)
+	std::vector<size_t> body_index;
+	// indices of the visible fixtures and transforms of their bodies (gathered at each build)
+	std::vector<size_t> visible;
+	std::vector<float> x, y, c, s;
+	// one instance per visible fixture
+	std::vector<Instance> instances;
+
+	void build(bool all, const WorldState* state);
+	template <bool Culled>
+	void compute(size_t n);
+
+	void push_back(b2Fixture* fixture, handle_t handle, float lx, float ly, float angle, float hx, float hy, const std::array<float, 3>& color);
+	/* Swap with the last element and pop */
+	void remove(size_t index);
+	void clear();
+      };
+
+      struct HandleData {
+	b2Fixture* fixture;
+	Shape shape;
+	size_t index;
+      };
+
+      struct QueryCallback : public b2QueryCallback {
+	bool ReportFixture(b2Fixture* fixture) override;
+
+	InstanceBuilder* builder = nullptr;
+      };
+
+      struct DestructionListener : public b2DestructionListener {
+	void SayGoodbye(b2Joint* joint) override;
+	void SayGoodbye(b2Fixture* fixture) override;
+
+	InstanceBuilder* builder = nullptr;
+      };
+
+      std::shared_ptr<b2World> _world;
+      ShapeArrays _shapes[NbShapes];
+
+      std::vector<HandleData> _handles;
+      std::vector<handle_t> _free_handles;
+      std::unordered_map<b2Fixture*, handle_t> _fixture_handles; // invalid_handle for the unsupported fixtures
+      DestructionListener _listener;
+      DestructionListeners* _listeners = nullptr;
+      // counts of the world at the last scan of sync(), and removal since then
+      int32 _nb_bodies = -1;
+      int32 _nb_proxies = -1;
+      bool _removed = false;
+
+      b2Vec2 _view_center = {0.0f, 0.0f};
+      b2Vec2 _view_half_size = {1.0f, 1.0f};
+      float _aspect_ratio = 1.0f;
+      b2Body* _follow = nullptr;
+      bool _culling = true;
+      QueryCallback _query;
+
+      const WorldStateCache* _state_cache = nullptr;
+      size_t _state_version = 0; // version of the world state the body indices were resolved for
+      bool _state_indices_valid = false;
+    };
+  } // namespace gui
+} // namespace robox2d
+
+#endif
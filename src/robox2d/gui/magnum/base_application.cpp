@@ -1,5 +1,7 @@
 #include "base_application.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 
 namespace robox2d {
@@ -8,46 +10,115 @@ namespace robox2d {
     Magnum::Platform::WindowlessGLContext* GlobalData::gl_context()
     {
       std::lock_guard<std::mutex> lg(_context_mutex);
-      if (_gl_contexts.size() == 0)
-	_create_contexts();
-      
-      for (size_t i = 0; i < _max_contexts; i++) {
-	if (!_used[i]) {
-	  _used[i] = true;
-	  return &_gl_contexts[i];
-	}
+      /* Do not overtake the requests already waiting */
+      if (!_queue.empty() || !_available())
+	return nullptr;
+      _stats.nb_acquired++;
+      return _take();
+    }
+
+    Magnum::Platform::WindowlessGLContext* GlobalData::acquire_gl_context(double timeout)
+    {
+      std::unique_lock<std::mutex> lock(_context_mutex);
+      if (_queue.empty() && _available()) {
+	_stats.nb_acquired++;
+	return _take();
       }
-      
-      return nullptr;
+
+      auto start = std::chrono::steady_clock::now();
+      size_t ticket = _next_ticket++;
+      _queue.push_back(ticket);
+      auto ready = [&]() { return _queue.front() == ticket && _available(); };
+      bool granted = true;
+      if (timeout < 0)
+	_context_cv.wait(lock, ready);
+      else
+	granted = _context_cv.wait_for(lock, std::chrono::duration<double>(timeout), ready);
+
+      _queue.erase(std::find(_queue.begin(), _queue.end(), ticket));
+      double wait = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      _stats.nb_waits++;
+      _stats.total_wait += wait;
+      _stats.max_wait = std::max(_stats.max_wait, wait);
+
+      Magnum::Platform::WindowlessGLContext* context = nullptr;
+      if (granted) {
+	_stats.nb_acquired++;
+	context = _take();
+      }
+      else
+	_stats.nb_timeouts++;
+      /* The next request in the queue may be able to go */
+      _context_cv.notify_all();
+      return context;
     }
     
     void GlobalData::free_gl_context(Magnum::Platform::WindowlessGLContext* context)
     {
-      std::lock_guard<std::mutex> lg(_context_mutex);
-      for (size_t i = 0; i < _gl_contexts.size(); i++) {
-	if (&_gl_contexts[i] == context) {
-	  _used[i] = false;
-	  break;
-	}
+      {
+	std::lock_guard<std::mutex> lg(_context_mutex);
+	auto it = std::find_if(_gl_contexts.begin(), _gl_contexts.end(),
+			       [context](const std::unique_ptr<Magnum::Platform::WindowlessGLContext>& c) { return c.get() == context; });
+	if (it == _gl_contexts.end())
+	  return;
+	if (_gl_contexts.size() > _max_contexts)
+	  _gl_contexts.erase(it); // the pool was shrunk while this context was in use
+	else
+	  _free.push_back(context);
       }
+      _context_cv.notify_all();
     }
     
     void GlobalData::set_max_contexts(size_t N)
+    {
+      {
+	std::lock_guard<std::mutex> lg(_context_mutex);
+	_max_contexts = N;
+	/* Destroy the idle contexts above the maximum (the ones in use are destroyed when freed) */
+	while (_gl_contexts.size() > _max_contexts && !_free.empty()) {
+	  Magnum::Platform::WindowlessGLContext* context = _free.back();
+	  _free.pop_back();
+	  _gl_contexts.erase(std::find_if(_gl_contexts.begin(), _gl_contexts.end(),
+					  [context](const std::unique_ptr<Magnum::Platform::WindowlessGLContext>& c) { return c.get() == context; }));
+	}
+      }
+      _context_cv.notify_all();
+    }
+
+    size_t GlobalData::max_contexts()
     {
       std::lock_guard<std::mutex> lg(_context_mutex);
-      _max_contexts = N;
-      _create_contexts();
+      return _max_contexts;
     }
-    
-    void GlobalData::_create_contexts()
+
+    size_t GlobalData::nb_contexts()
+    {
+      std::lock_guard<std::mutex> lg(_context_mutex);
+      return _gl_contexts.size();
+    }
+
+    GLContextStats GlobalData::stats()
+    {
+      std::lock_guard<std::mutex> lg(_context_mutex);
+      return _stats;
+    }
+
+    void GlobalData::reset_stats()
     {
-      _used.clear();
-      _gl_contexts.clear();
-      _gl_contexts.reserve(_max_contexts);
-      for (size_t i = 0; i < _max_contexts; i++) {
-	_used.push_back(false);
-	_gl_contexts.emplace_back(Magnum::Platform::WindowlessGLContext{{}});
+      std::lock_guard<std::mutex> lg(_context_mutex);
+      _stats = GLContextStats();
+    }
+
+    Magnum::Platform::WindowlessGLContext* GlobalData::_take()
+    {
+      if (!_free.empty()) {
+	Magnum::Platform::WindowlessGLContext* context = _free.back();
+	_free.pop_back();
+	return context;
       }
+      /* Lazy creation */
+      _gl_contexts.emplace_back(new Magnum::Platform::WindowlessGLContext{{}});
+      return _gl_contexts.back().get();
     }
     
     // BaseApplication
@@ -88,43 +159,11 @@ namespace robox2d {
       _lineInstanceData = std::unique_ptr<Magnum::Containers::Array<InstanceData>>(new Magnum::Containers::Array<InstanceData>() ) ;
 
 
-      if(_world)
-	for(b2Body* body = _world->GetBodyList(); body; body = body->GetNext())
-	  for(b2Fixture* fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext())
-	  {
-	    auto obj = new Object2D{&_scene};
-	    fixture->SetUserData(obj);
-	    // todo triple check this... Very likely to not work properly as we assume the fixture is with rot = 0
-	    //here we assume a single fixture
-
-
-	    switch(fixture->GetShape()->GetType())
-	      {
-	      case b2Shape::e_circle: // if shape is a circle
-		 {
-		   b2CircleShape* circle = static_cast<b2CircleShape*>(fixture->GetShape());
-		   obj->setScaling(Magnum::Vector2(circle->m_radius, circle->m_radius));
-		   new Drawable{*obj, *_circleInstanceData, 0xeac9a5_rgbf, *_drawables};
-		   break;
-		 }
-	      case b2Shape::e_polygon: // if shape is a box (more advanced polygon not supported yet)
-		{
-		  b2PolygonShape* poly =  static_cast<b2PolygonShape*>(fixture->GetShape());
-		  auto v = poly->m_vertices;
-		  auto hx = (v[1]-v[0]).Length()/2;
-		  auto hy = (v[2]-v[1]).Length()/2;
-		  Magnum::Vector2 halfSize(hx, hy);
-		  obj->setScaling(halfSize);
-		  new Drawable{*obj, *_boxInstanceData, 0xa5c9ea_rgbf, *_drawables};	  
-		  break;
-		}
-	      default: // not supported shapes
-		{
-		  std::cout<<"Warning Shape Type not supported"<<std::endl;
-		  break;
-		}
-	      }
-	  }
+      /* Flat arrays of the fixtures of the world */
+      _builder.set_world(_world, &simu->destruction_listeners());
+      _builder.set_state_cache(&simu->world_state_cache());
+      if (height > 0)
+	_builder.set_aspect_ratio(width / static_cast<float>(height));
 
       /*for(b2Joint* joint = _world->GetJointList(); joint; joint = joint->GetNext())
 	{
@@ -141,52 +180,46 @@ namespace robox2d {
 
     void BaseApplication::update_graphics()
     {
-      /* update all object positions */
-      if(_world)
-	{
-	  for(b2Body* body = _world->GetBodyList(); body; body = body->GetNext())
-	    for(b2Fixture* fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext())
-	      switch(fixture->GetShape()->GetType())
-		{
-		case b2Shape::e_circle: // if shape is a circle
-		  {
-		    b2CircleShape* circle = static_cast<b2CircleShape*>(fixture->GetShape());
-		    auto pos = body->GetWorldPoint(circle->m_p);
-		    (*static_cast<Object2D*>(fixture->GetUserData()))
-		      .setTranslation({pos.x, pos.y});		    
-		   break;
-		 }
-		case b2Shape::e_polygon: // if shape is a box (more advanced polygon not supported yet)
-		  {
-		    b2PolygonShape* poly =  static_cast<b2PolygonShape*>(fixture->GetShape());
-		    auto v = poly->m_vertices;
-		    auto center = (v[2]+v[0]);
-		    center*=0.5f;
-		    auto pos = body->GetWorldPoint(center);
-		    (*static_cast<Object2D*>(fixture->GetUserData()))
-		      .setTranslation({pos.x, pos.y})
-		      .setRotation(Magnum::Complex::rotation(Magnum::Rad(body->GetAngle())));
-	  		  
-		  break;
-		}
-	      default: // not supported shapes
-		{
-		  std::cout<<"Warning Shape Type not supported"<<std::endl;
-		  break;
-		}
-	      }
-	  
-	  
-	  /*for(b2Joint* joint = _world->GetJointList(); joint; joint = joint->GetNext())
-	    {
-	    (*static_cast<Object2D*>(joint->GetUserData()))
-	      .setTranslation({joint->GetAnchorB().x, joint->GetAnchorB().y})
-	      .setScaling(Magnum::Vector2(joint->GetReactionForce(1).Length()*100, joint->GetReactionForce(1).Length()*100))
-	      .setRotation(Magnum::Complex::rotation(Magnum::Rad(std::atan2(joint->GetReactionForce(1).y,joint->GetReactionForce(1).x))));
-	    std::cout<<joint->GetReactionForce(1).x<<"  "<<joint->GetReactionForce(1).y<<std::endl;
-	    }*/
-	  
-	}
+      /* compute the instances of the visible fixtures (unless they are given) */
+      if (!_frame_instances)
+	_builder.build();
+
+      /* move the camera to the view of the builder (which may follow a body) */
+      b2Vec2 center = _frame_instances ? _frame_instances->view_center : _builder.view_center();
+      b2Vec2 half_size = _frame_instances ? _frame_instances->view_half_size : _builder.view_half_size();
+      _cameraObject->setTranslation({center.x, center.y});
+      _camera->setProjectionMatrix(Magnum::Matrix3::projection({2.0f * half_size.x, 2.0f * half_size.y}));
+    }
+
+    void BaseApplication::draw_instances()
+    {
+      /* Extra drawables */
+      arrayResize(*_boxInstanceData, 0);
+      arrayResize(*_circleInstanceData, 0);
+      arrayResize(*_lineInstanceData, 0);
+      _camera->draw(*_drawables);
+
+      /* Upload instance data to the GPU and draw everything in a single call per shape (and per source) */
+      /* (the instances of the builder are in world coordinates, the drawables already include the camera) */
+      Magnum::Matrix3 projection = _camera->projectionMatrix();
+      Magnum::Matrix3 view_projection = projection * _camera->cameraMatrix();
+      const auto& boxes = _frame_instances ? _frame_instances->boxes : _builder.instances(InstanceBuilder::Box);
+      const auto& circles = _frame_instances ? _frame_instances->circles : _builder.instances(InstanceBuilder::Circle);
+      _draw(*_boxMesh, boxes.data(), boxes.size(), view_projection);
+      _draw(*_circleMesh, circles.data(), circles.size(), view_projection);
+      _draw(*_boxMesh, _boxInstanceData->data(), _boxInstanceData->size(), projection);
+      _draw(*_circleMesh, _circleInstanceData->data(), _circleInstanceData->size(), projection);
+      _draw(*_lineMesh, _lineInstanceData->data(), _lineInstanceData->size(), projection);
+    }
+
+    void BaseApplication::_draw(Magnum::GL::Mesh& mesh, const void* instances, size_t nb_instances, const Magnum::Matrix3& transformation_projection)
+    {
+      if (nb_instances == 0)
+	return;
+      _instanceBuffer->setData({instances, nb_instances * sizeof(InstanceData)}, Magnum::GL::BufferUsage::DynamicDraw);
+      mesh.setInstanceCount(nb_instances);
+      _shader->setTransformationProjectionMatrix(transformation_projection)
+	.draw(mesh);
     }
     
     bool BaseApplication::done() const
@@ -1,6 +1,8 @@
 #ifndef ROBOX2D_GUI_MAGNUM_BASE_APPLICATION_HPP
 #define ROBOX2D_GUI_MAGNUM_BASE_APPLICATION_HPP
 
+#include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <unistd.h>
 #include <unordered_map>
@@ -36,16 +38,13 @@
 #endif
 
 #include "robox2d/simu.hpp"
+#include "robox2d/gui/instance_builder.hpp"
 
 #define get_gl_context_with_sleep_robox2d(name, ms_sleep)			\
-  /* Create/Get GLContext */						\
+  /* Create/Get GLContext (blocks until one is available) */		\
   Corrade::Utility::Debug name##_magnum_silence_output{nullptr};	\
-  Magnum::Platform::WindowlessGLContext* name = nullptr;		\
-  while (name == nullptr) {						\
-    name = robox2d::gui::GlobalData::instance()->gl_context(); \
-    /* Sleep for some ms */						\
-    usleep(ms_sleep * 1000);						\
-  }									\
+  Magnum::Platform::WindowlessGLContext* name =				\
+    robox2d::gui::GlobalData::instance()->acquire_gl_context();	\
   while (!name->makeCurrent()) {					\
     /* Sleep for some ms */						\
     usleep(ms_sleep * 1000);						\
@@ -71,8 +70,27 @@ namespace robox2d {
       Magnum::Matrix3 transformation;
       Magnum::Color3 color;
     };
+
+    static_assert(sizeof(InstanceData) == sizeof(Instance), "InstanceData and gui::Instance must have the same layout");
     
     
+    /* Statistics of the GL context pool (see GlobalData::acquire_gl_context) */
+    struct GLContextStats {
+      size_t nb_acquired = 0; // contexts granted
+      size_t nb_waits = 0; // requests that had to wait for a context
+      size_t nb_timeouts = 0; // requests that gave up
+      double total_wait = 0.0; // seconds spent waiting (all requests)
+      double max_wait = 0.0;
+
+      double mean_wait() const { return nb_acquired + nb_timeouts ? total_wait / (nb_acquired + nb_timeouts) : 0.0; }
+    };
+
+    /**
+     * @brief Pool of windowless GL contexts shared by the headless renderers.
+     *
+     * Contexts are created lazily (up to max_contexts). A request waits on a condition variable when they are
+     * all in use, and requests are served in FIFO order.
+     */
     struct GlobalData {
     public:
       static GlobalData* instance()
@@ -83,23 +101,37 @@ namespace robox2d {
       
       GlobalData(const GlobalData&) = delete;
       void operator=(const GlobalData&) = delete;
-	
+
+      /* Context if one is available right away, nullptr otherwise */
       Magnum::Platform::WindowlessGLContext* gl_context();
+      /* Wait for a context (at most timeout seconds if timeout >= 0); nullptr on timeout */
+      Magnum::Platform::WindowlessGLContext* acquire_gl_context(double timeout = -1.0);
       void free_gl_context(Magnum::Platform::WindowlessGLContext* context);
 	
-      /* You should call this before starting to draw or after finished */
+      /* Can be called at any time: contexts in use above the new maximum are destroyed when they are freed */
       void set_max_contexts(size_t N);
+      size_t max_contexts();
+      /* Number of contexts created so far (idle or in use) */
+      size_t nb_contexts();
+
+      GLContextStats stats();
+      void reset_stats();
 	
     private:
       GlobalData() = default;
       ~GlobalData() = default;
+
+      bool _available() const { return !_free.empty() || _gl_contexts.size() < _max_contexts; }
+      Magnum::Platform::WindowlessGLContext* _take();
 	
-      void _create_contexts();
-	
-      std::vector<Magnum::Platform::WindowlessGLContext> _gl_contexts;
-      std::vector<bool> _used;
+      std::vector<std::unique_ptr<Magnum::Platform::WindowlessGLContext>> _gl_contexts;
+      std::vector<Magnum::Platform::WindowlessGLContext*> _free;
+      std::deque<size_t> _queue; // tickets of the waiting requests
+      size_t _next_ticket = 0;
       std::mutex _context_mutex;
+      std::condition_variable _context_cv;
       size_t _max_contexts = 4;
+      GLContextStats _stats;
     };
       
 
@@ -126,12 +158,26 @@ namespace robox2d {
 	
       void init(robox2d::Simu* simu, size_t width, size_t height);
       void update_graphics();
-      	
+      /* Draw the instances of the world and of the extra drawables (the framebuffer must be bound) */
+      void draw_instances();
+
+      InstanceBuilder& instance_builder() { return _builder; }
+
+      /**
+       * @brief Draw the given instances instead of the ones of the builder (nullptr to go back to the builder).
+       *
+       * Used when the instances are built in another thread (see ThreadedGraphics): the world is not read at all.
+       */
+      void set_frame(const FrameInstances* frame) { _frame_instances = frame; }
+      /* Extra drawables (drawn on top of the fixtures of the world) */
       Magnum::SceneGraph::DrawableGroup2D& drawables() { return *_drawables; }
       Scene2D& scene() { return _scene; }
       Magnum::SceneGraph::Camera2D* camera() { return &*_camera; }
 
-      Corrade::Containers::Optional<Magnum::Image2D>& image() { return _image; }
+      /* Image of the last rendered frame */
+      virtual Corrade::Containers::Optional<Magnum::Image2D>& image() { return _image; }
+      /* Image of the last frame already read back (never blocks; same as image() when the readback is synchronous) */
+      virtual Corrade::Containers::Optional<Magnum::Image2D>& latest_image() { return _image; }
 
       
       bool done() const;
@@ -141,6 +187,8 @@ namespace robox2d {
       void GLCleanUp();
       
     protected:
+      void _draw(Magnum::GL::Mesh& mesh, const void* instances, size_t nb_instances, const Magnum::Matrix3& transformation_projection);
+
       /* Magnum */
       std::unique_ptr<Magnum::Shaders::Flat2D> _shader;//{Magnum::NoCreate};
       std::unique_ptr<Magnum::GL::Buffer> _instanceBuffer;//{Magnum::NoCreate};
@@ -159,6 +207,8 @@ namespace robox2d {
       std::unique_ptr<Magnum::SceneGraph::Camera2D> _camera;
       std::unique_ptr<Magnum::SceneGraph::DrawableGroup2D> _drawables;
       std::shared_ptr<b2World> _world;
+      InstanceBuilder _builder;
+      const FrameInstances* _frame_instances = nullptr;
       //Magnum::Containers::Optional<b2World> _world;
       Corrade::Containers::Optional<Magnum::Image2D> _image;
       
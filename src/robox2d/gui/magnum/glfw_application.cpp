@@ -1,5 +1,6 @@
 #include "glfw_application.hpp"
 
+#include <cmath>
 #include <iostream>
 
 #include <Magnum/GL/DefaultFramebuffer.h>
@@ -53,6 +54,8 @@ namespace robox2d {
 	Magnum::GL::defaultFramebuffer.setViewport({{}, size});
 	
 	_camera->setViewport(size);
+	if (size.y() > 0)
+	  _builder.set_aspect_ratio(size.x() / static_cast<float>(size.y()));
       }
       
       void GlfwApplication::drawEvent()
@@ -62,28 +65,8 @@ namespace robox2d {
 	/* Update graphic meshes/materials and render */
 	update_graphics();
 
-	/* Populate instance data with transformations and colors */
-	
-	arrayResize(*_boxInstanceData, 0);
-	arrayResize(*_circleInstanceData, 0);
-	arrayResize(*_lineInstanceData, 0);
-	_camera->draw(*_drawables);
-
-	/* Upload instance data to the GPU and draw everything in a single call per shape */
-	_instanceBuffer->setData(*_boxInstanceData, Magnum::GL::BufferUsage::DynamicDraw);
-	_boxMesh->setInstanceCount(_boxInstanceData->size());
-	_shader->setTransformationProjectionMatrix(_camera->projectionMatrix())
-	  .draw(*_boxMesh);
-
-	_instanceBuffer->setData(*_circleInstanceData, Magnum::GL::BufferUsage::DynamicDraw);
-	_circleMesh->setInstanceCount(_circleInstanceData->size());
-	_shader->setTransformationProjectionMatrix(_camera->projectionMatrix())
-	  .draw(*_circleMesh);
-
-	_instanceBuffer->setData(*_lineInstanceData, Magnum::GL::BufferUsage::DynamicDraw);
-	_lineMesh->setInstanceCount(_lineInstanceData->size());
-	_shader->setTransformationProjectionMatrix(_camera->projectionMatrix())
-	  .draw(*_lineMesh);
+	/* Draw the instances of the world and the extra drawables */
+	draw_instances();
 
 	_image = Magnum::GL::defaultFramebuffer.read(Magnum::GL::defaultFramebuffer.viewport(), {Magnum::PixelFormat::RGB8Unorm});
 	
@@ -98,11 +81,30 @@ namespace robox2d {
       
       void GlfwApplication::keyPressEvent(KeyEvent& event)
       {
+	/* Arrows move the view (and stop following a body) */
+	b2Vec2 move = {0.0f, 0.0f};
+	if (event.key() == KeyEvent::Key::Left)
+	  move.x = -1.0f;
+	else if (event.key() == KeyEvent::Key::Right)
+	  move.x = 1.0f;
+	else if (event.key() == KeyEvent::Key::Up)
+	  move.y = 1.0f;
+	else if (event.key() == KeyEvent::Key::Down)
+	  move.y = -1.0f;
+	if (move.x != 0.0f || move.y != 0.0f) {
+	  b2Vec2 half_size = _builder.view_half_size();
+	  _builder.follow(nullptr);
+	  _builder.set_view_center(_builder.view_center() + b2Vec2(move.x * half_size.x * 0.1f, move.y * half_size.y * 0.1f));
+	}
 	event.setAccepted();
       }
       
       void GlfwApplication::mouseScrollEvent(MouseScrollEvent& event)
       {
+	/* Zoom */
+	float factor = std::pow(0.9f, event.offset().y());
+	b2Vec2 half_size = _builder.view_half_size();
+	_builder.set_view(_builder.view_center(), {half_size.x * factor, half_size.y * factor});
 	event.setAccepted();
       }
       
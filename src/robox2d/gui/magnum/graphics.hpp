@@ -44,6 +44,19 @@ namespace robox2d {
         _enabled = enable;
       }
 
+      /* Show the rectangle of the world of given center and half size (extended to the aspect ratio of the image) */
+      void look_at(const b2Vec2& center, const b2Vec2& half_size = {1.0f, 1.0f})
+      {
+	_magnum_app->instance_builder().follow(nullptr);
+	_magnum_app->instance_builder().set_view(center, half_size);
+      }
+
+      /* Keep the view centered on a body (nullptr to stop) */
+      void follow(b2Body* body) { _magnum_app->instance_builder().follow(body); }
+
+      /* Only draw the fixtures in the view (enabled by default) */
+      void set_culling(bool enable) { _magnum_app->instance_builder().set_culling(enable); }
+
 /*
 	void look_at(const Eigen::Vector3d& camera_pos,
 	const Eigen::Vector3d& look_at = Eigen::Vector3d(0, 0, 0),
@@ -98,6 +111,22 @@ namespace robox2d {
 	    return rgb_from_image(image);
 	  return Image();
 	}
+
+	/* Last image already read back (does not wait for the frames still in flight, see WindowlessGLApplication::set_readback_ring) */
+	Magnum::Image2D* magnum_latest_image()
+	{
+	  if (_magnum_app->latest_image())
+	    return &(*_magnum_app->latest_image());
+	  return nullptr;
+	}
+
+	Image latest_image()
+	{
+	  auto image = magnum_latest_image();
+	  if (image)
+	    return rgb_from_image(image);
+	  return Image();
+	}
       /*
 	GrayscaleImage depth_image() override { return _magnum_app->depthImage(); }
 	GrayscaleImage raw_depth_image() override { return _magnum_app->rawDepthImage(); }
@@ -0,0 +1,203 @@
+#ifndef ROBOX2D_GUI_MAGNUM_THREADED_GRAPHICS_HPP
+#define ROBOX2D_GUI_MAGNUM_THREADED_GRAPHICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include "../base.hpp"
+#include "../instance_builder.hpp"
+#include "../triple_buffer.hpp"
+#include "helper.hpp"
+#include "windowless_gl_application.hpp"
+
+#include "robox2d/simu.hpp"
+
+namespace robox2d {
+    class Simu;
+
+  namespace gui {
+
+    /**
+     * @brief Graphics rendering in their own thread.
+     *
+     * refresh() (called by Simu::run, in the simulation thread) only builds the instances of the visible fixtures
+     * and publishes them in a lock-free triple buffer; it never waits for the renderer. The render thread owns the
+     * application and its GL context (taken from GlobalData) and draws the last
+     * published frame; frames are skipped when rendering is slower than the simulation.
+     *
+     * The sync of the simu is disabled (the simulation does not wait for the graphic period); call
+     * simu->set_sync(true) after construction to run in real time.
+     *
+     * Only windowless applications are supported: GLFW windows must be created and have their events processed
+     * in the main thread (use Graphics for them).
+     */
+    template <typename T = magnum::WindowlessGLApplication>
+    class ThreadedGraphics : public Base {
+      static_assert(std::is_base_of<Magnum::Platform::WindowlessApplication, T>::value,
+		    "ThreadedGraphics only supports windowless applications (GLFW needs the main thread)");
+    public:
+      ThreadedGraphics(robox2d::Simu* simu, unsigned int width = 640, unsigned int height = 480, const std::string& title = "ROBOX2D")
+	: Base(simu), _width(width), _height(height), _frame_counter(0), _enabled(true),
+	  _ready(false), _stop(false), _done(false), _capture(false), _nb_rendered(0)
+      {
+	_thread = std::thread([this, simu, title]() { _render_loop(simu, title); });
+
+	/* The application reads the world while it is created: wait for it */
+	{
+	  std::unique_lock<std::mutex> lock(_mutex);
+	  _cv.wait(lock, [this]() { return _ready; });
+	}
+	_builder.set_world(simu->world(), &simu->destruction_listeners());
+	_builder.set_state_cache(&simu->world_state_cache());
+	_builder.set_aspect_ratio(width / static_cast<float>(height));
+	simu->set_sync(false);
+      }
+
+      ~ThreadedGraphics()
+      {
+	{
+	  std::lock_guard<std::mutex> lock(_mutex);
+	  _stop = true;
+	}
+	_cv.notify_all();
+	_thread.join();
+      }
+
+      bool done() const override
+      {
+	return _done;
+      }
+
+      void refresh() override
+      {
+	if (!_enabled)
+	  return;
+
+	_builder.build();
+	FrameInstances& frame = _frames.write();
+	_builder.copy_to(frame);
+	frame.frame = _frame_counter++;
+	_frames.publish();
+	/* Taking the mutex orders the publish with the check of the render thread: the notification cannot be lost */
+	{
+	  std::lock_guard<std::mutex> lock(_mutex);
+	}
+	_cv.notify_one();
+      }
+
+      void set_enable(bool enable) override
+      {
+        _enabled = enable;
+      }
+
+      /* View (applied to the next published frames, see Graphics) */
+      void look_at(const b2Vec2& center, const b2Vec2& half_size = {1.0f, 1.0f})
+      {
+	_builder.follow(nullptr);
+	_builder.set_view(center, half_size);
+      }
+      void follow(b2Body* body) { _builder.follow(body); }
+      void set_culling(bool enable) { _builder.set_culling(enable); }
+      InstanceBuilder& instance_builder() { return _builder; }
+
+      /* Copy the rendered images for image() (converted in the render thread) */
+      void set_capture(bool capture) { _capture = capture; }
+
+      /* The Magnum image belongs to the render thread */
+      Magnum::Image2D* magnum_image() override { return nullptr; }
+
+      /* Last captured image (see set_capture) */
+      Image image() override
+      {
+	std::lock_guard<std::mutex> lock(_image_mutex);
+	return _image;
+      }
+
+      /* Number of frames published by the simulation and drawn by the render thread */
+      size_t nb_published() const { return _frame_counter; }
+      size_t nb_rendered() const { return _nb_rendered; }
+
+    protected:
+      void _render_loop(robox2d::Simu* simu, const std::string& title)
+      {
+	/* GL context of this thread */
+	Magnum::Platform::WindowlessGLContext* gl_context = GlobalData::instance()->acquire_gl_context();
+	while (!gl_context->makeCurrent())
+	  usleep(1000);
+	std::unique_ptr<Magnum::Platform::GLContext> magnum_context(new Magnum::Platform::GLContext);
+
+	std::unique_ptr<BaseApplication> app;
+	{
+	  Corrade::Utility::Debug magnum_silence_output{nullptr};
+	  app.reset(make_application<T>(simu, _width, _height, title));
+	}
+	/* From now on, the application only draws the published frames: it does not touch the world */
+	app->instance_builder().set_world(nullptr);
+	app->instance_builder().set_state_cache(nullptr);
+	{
+	  std::lock_guard<std::mutex> lock(_mutex);
+	  _ready = true;
+	}
+	_cv.notify_all();
+
+	/* Only new frames are drawn (the timeout is a safety net) */
+	const auto idle = std::chrono::milliseconds(100);
+	while (!_stop) {
+	  {
+	    std::unique_lock<std::mutex> lock(_mutex);
+	    _cv.wait_for(lock, idle, [this]() { return _stop || _frames.fresh(); });
+	  }
+	  if (_stop)
+	    break;
+
+	  bool fresh = _frames.update();
+	  if (!fresh)
+	    continue;
+
+	  app->set_frame(&_frames.read());
+	  app->render();
+	  _nb_rendered++;
+	  if (app->done())
+	    _done = true;
+
+	  if (_capture && app->latest_image()) {
+	    Image image = rgb_from_image(&*app->latest_image());
+	    std::lock_guard<std::mutex> lock(_image_mutex);
+	    _image = std::move(image);
+	  }
+	}
+
+	/* The GL objects are destroyed in the thread of their context */
+	app.reset();
+	magnum_context.reset();
+	GlobalData::instance()->free_gl_context(gl_context);
+      }
+
+      size_t _width, _height;
+      std::atomic<size_t> _frame_counter;
+      bool _enabled;
+
+      InstanceBuilder _builder; // simulation thread
+      TripleBuffer<FrameInstances> _frames;
+
+      std::thread _thread;
+      std::mutex _mutex;
+      std::condition_variable _cv;
+      bool _ready;
+      std::atomic<bool> _stop;
+      std::atomic<bool> _done;
+      std::atomic<bool> _capture;
+      std::atomic<size_t> _nb_rendered;
+
+      std::mutex _image_mutex;
+      Image _image;
+    };
+
+  } // namespace gui
+} // namespace robox2d
+
+#endif
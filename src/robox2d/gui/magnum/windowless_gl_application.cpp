@@ -2,11 +2,13 @@
 
 // #include <Magnum/DebugTools/Screenshot.h>
 #include <Magnum/GL/RenderbufferFormat.h>
+#include <Magnum/GL/PixelFormat.h>
 #include <Magnum/GL/Renderer.h>
 
 
 
 
+#include <cstring>
 #include <iostream>
 #include <fstream>
 
@@ -78,23 +80,69 @@ namespace robox2d {
                 /* Clear framebuffer */
                 _framebuffer.clear(Magnum::GL::FramebufferClear::Color | Magnum::GL::FramebufferClear::Depth);
                 
-                arrayResize(*_boxInstanceData, 0);
-	            arrayResize(*_circleInstanceData, 0);
                 /* Draw with main camera */
-                _camera->draw(*_drawables);
+                draw_instances();
 
-                /* Upload instance data to the GPU and draw everything in a single call per shape */
-                _instanceBuffer->setData(*_boxInstanceData, Magnum::GL::BufferUsage::DynamicDraw);
-                _boxMesh->setInstanceCount(_boxInstanceData->size());
-                _shader->setTransformationProjectionMatrix(_camera->projectionMatrix())
-                    .draw(*_boxMesh);
+                if (_ring.empty()) {
+                    _image = _framebuffer.read(_framebuffer.viewport(), {Magnum::PixelFormat::RGB8Unorm});
+                    _image_frame = _frame++;
+                    return;
+                }
+
+                /* The slot of this frame holds the oldest frame in flight: fetch it before reusing the buffer */
+                ReadbackSlot& slot = _ring[_frame % _ring.size()];
+                if (slot.pending)
+                    _fetch(slot);
+                _framebuffer.read(_framebuffer.viewport(), slot.image, Magnum::GL::BufferUsage::StreamRead);
+                slot.frame = _frame++;
+                slot.pending = true;
+            }
+
+            void WindowlessGLApplication::set_readback_ring(size_t size)
+            {
+                /* Do not lose the frames in flight */
+                image();
+                _ring.clear();
+                _ring.resize(size);
+            }
 
-                _instanceBuffer->setData(*_circleInstanceData, Magnum::GL::BufferUsage::DynamicDraw);
-                _circleMesh->setInstanceCount(_circleInstanceData->size());
-                _shader->setTransformationProjectionMatrix(_camera->projectionMatrix())
-                    .draw(*_circleMesh);
+            Corrade::Containers::Optional<Magnum::Image2D>& WindowlessGLApplication::image()
+            {
+                if (_frame > 0)
+                    frame_image(_frame - 1);
+                return _image;
+            }
+
+            Magnum::Image2D* WindowlessGLApplication::frame_image(size_t frame)
+            {
+                /* Fetch the frames in flight in order, up to the requested one */
+                for (size_t f = _frame > _ring.size() ? _frame - _ring.size() : 0; f <= frame && f < _frame; f++) {
+                    ReadbackSlot& slot = _ring[f % _ring.size()];
+                    if (slot.pending && slot.frame == f)
+                        _fetch(slot);
+                }
+                if (!_image || _image_frame != frame)
+                    return nullptr;
+                return &*_image;
+            }
+
+            void WindowlessGLApplication::_fetch(ReadbackSlot& slot)
+            {
+                Magnum::GL::Buffer& buffer = slot.image.buffer();
+                const std::size_t size = buffer.size();
+                /* Blocks only if the GPU has not finished writing this frame */
+                Corrade::Containers::ArrayView<const char> pixels = buffer.map(0, size, Magnum::GL::Buffer::MapFlag::Read);
+
+                /* Reuse the memory of the previous image when possible */
+                if (!_image || _image->size() != slot.image.size() || _image->data().size() != size) {
+                    Corrade::Containers::Array<char> data{Corrade::Containers::NoInit, size};
+                    _image = Magnum::Image2D{slot.image.storage(), Magnum::PixelFormat::RGB8Unorm, slot.image.size(), std::move(data)};
+                }
+                std::memcpy(_image->data().data(), pixels.data(), size);
 
-                _image = _framebuffer.read(_framebuffer.viewport(), {Magnum::PixelFormat::RGB8Unorm});
+                buffer.unmap();
+                _image_frame = slot.frame;
+                slot.pending = false;
             }
         } // namespace magnum
     } // namespace gui
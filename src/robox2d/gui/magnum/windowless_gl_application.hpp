@@ -1,6 +1,9 @@
 #ifndef ROBOX2D_GUI_MAGNUM_GLX_APPLICATION_HPP
 #define ROBOX2D_GUI_MAGNUM_GLX_APPLICATION_HPP
 
+#include <vector>
+
+#include <Magnum/GL/BufferImage.h>
 #include <Magnum/GL/Renderbuffer.h>
 #include <Magnum/PixelFormat.h>
 #include <robox2d/gui/magnum/base_application.hpp>
@@ -20,11 +23,45 @@ namespace robox2d {
 
                 void render() override;
 
+                /**
+                 * @brief Number of pixel buffers used to read the frames back asynchronously.
+                 *
+                 * With 0 (default), render() reads the framebuffer synchronously. With N > 0, the pixels of a frame
+                 * are copied into a pixel buffer object and fetched by the render N frames later, which reuses the
+                 * buffer (or earlier, when they are requested), so the CPU does not wait for the GPU at each frame.
+                 */
+                void set_readback_ring(size_t size);
+                size_t readback_ring() const { return _ring.size(); }
+
+                /* Number of frames rendered so far */
+                size_t frame() const { return _frame; }
+                /* Index of the frame in latest_image() (only meaningful once a frame has been read back) */
+                size_t latest_frame() const { return _image_frame; }
+
+                /* Blocks until the last rendered frame is read back */
+                Corrade::Containers::Optional<Magnum::Image2D>& image() override;
+                /* Last frame already read back, never blocks (up to readback_ring() frames late) */
+                Corrade::Containers::Optional<Magnum::Image2D>& latest_image() override { return _image; }
+                /* Blocks until the given frame is read back; nullptr if it is not available anymore */
+                Magnum::Image2D* frame_image(size_t frame);
+
             protected:
+                struct ReadbackSlot {
+                    Magnum::GL::BufferImage2D image{Magnum::GL::PixelFormat::RGB, Magnum::GL::PixelType::UnsignedByte};
+                    size_t frame = 0;
+                    bool pending = false;
+                };
+
+                void _fetch(ReadbackSlot& slot);
+
                 Magnum::GL::Framebuffer _framebuffer{Magnum::NoCreate};
                 Magnum::PixelFormat _format;
                 Magnum::GL::Renderbuffer _color, _depth;
 
+                std::vector<ReadbackSlot> _ring;
+                size_t _frame = 0;
+                size_t _image_frame = 0;
+
                 // size_t _index = 0;
 
                 virtual int exec() override { return 0; }
@@ -0,0 +1,55 @@
+#ifndef ROBOX2D_GUI_TRIPLE_BUFFER_HPP
+#define ROBOX2D_GUI_TRIPLE_BUFFER_HPP
+
+#include <atomic>
+
+namespace robox2d {
+  namespace gui {
+
+    /**
+     * @brief Lock-free triple buffer between one writer thread and one reader thread.
+     *
+     * The writer fills write() and publishes it; the reader calls update() to get the last published buffer in
+     * read(). Neither side ever waits for the other: when the reader is slower, intermediate buffers are skipped.
+     */
+    template <typename T>
+    class TripleBuffer {
+    public:
+      TripleBuffer() : _middle(1), _back(0), _front(2) {}
+
+      TripleBuffer(const TripleBuffer&) = delete;
+      TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+      /* Writer side */
+      T& write() { return _buffers[_back]; }
+      void publish()
+      {
+	_back = _middle.exchange(_back | _fresh, std::memory_order_acq_rel) & _index;
+      }
+
+      /* Reader side: return true if a new buffer was published since the last update */
+      bool update()
+      {
+	if (!(_middle.load(std::memory_order_acquire) & _fresh))
+	  return false;
+	_front = _middle.exchange(_front, std::memory_order_acq_rel) & _index;
+	return true;
+      }
+      /* True if update() would return a new buffer */
+      bool fresh() const { return _middle.load(std::memory_order_acquire) & _fresh; }
+      const T& read() const { return _buffers[_front]; }
+      T& read() { return _buffers[_front]; }
+
+    protected:
+      static constexpr unsigned _index = 3;
+      static constexpr unsigned _fresh = 4;
+
+      T _buffers[3];
+      std::atomic<unsigned> _middle; // index of the middle buffer, with the fresh bit
+      unsigned _back; // owned by the writer
+      unsigned _front; // owned by the reader
+    };
+  } // namespace gui
+} // namespace robox2d
+
+#endif
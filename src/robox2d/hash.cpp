@@ -0,0 +1,59 @@
+#include "hash.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+namespace robox2d {
+
+  uint64_t world_hash(const b2World& world, uint64_t seed)
+  {
+    uint64_t h = hash_mix(0xcbf29ce484222325ULL, seed);
+    for (const b2Body* body = world.GetBodyList(); body; body = body->GetNext()) {
+      const b2Transform& xf = body->GetTransform();
+      const b2Vec2& v = body->GetLinearVelocity();
+      h = hash_mix(h, float_bits(xf.p.x, xf.p.y));
+      h = hash_mix(h, float_bits(xf.q.s, xf.q.c));
+      h = hash_mix(h, float_bits(v.x, v.y));
+      h = hash_mix(h, float_bits(body->GetAngularVelocity(), 0.0f));
+    }
+    return h;
+  }
+
+  bool HashStream::save(const std::string& filename) const
+  {
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    uint64_t size = _entries.size();
+    out.write(reinterpret_cast<const char*>(&size), sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(_entries.data()), size * sizeof(Entry));
+    return out.good();
+  }
+
+  bool HashStream::load(const std::string& filename)
+  {
+    clear();
+    std::ifstream in(filename, std::ios::binary);
+    uint64_t size = 0;
+    in.read(reinterpret_cast<char*>(&size), sizeof(uint64_t));
+    if (!in)
+      return false;
+    std::vector<Entry> entries(size);
+    in.read(reinterpret_cast<char*>(entries.data()), size * sizeof(Entry));
+    if (!in)
+      return false;
+    for (auto& e : entries)
+      push_back(e.tick, e.hash);
+    return true;
+  }
+
+  size_t first_divergence(const HashStream& a, const HashStream& b)
+  {
+    size_t n = std::min(a.size(), b.size());
+    for (size_t i = 0; i < n; i++) {
+      if (a[i].tick != b[i].tick)
+	return std::min(a[i].tick, b[i].tick);
+      if (a[i].hash != b[i].hash)
+	return a[i].tick;
+    }
+    return no_divergence;
+  }
+} // namespace robox2d
@@ -0,0 +1,79 @@
+#ifndef ROBOX2D_HASH_HPP
+#define ROBOX2D_HASH_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <box2d/box2d.h>
+
+namespace robox2d {
+
+  /* Fast (non cryptographic) 64-bit hashing of bit patterns */
+  inline uint64_t hash_mix(uint64_t h, uint64_t v)
+  {
+    h = (h ^ v) * 0xff51afd7ed558ccdULL;
+    return h ^ (h >> 32);
+  }
+
+  inline uint64_t float_bits(float a, float b)
+  {
+    uint32_t x, y;
+    std::memcpy(&x, &a, sizeof(float));
+    std::memcpy(&y, &b, sizeof(float));
+    return (uint64_t(x) << 32) | y;
+  }
+
+  /**
+   * @brief Hash of the state of a world: transforms and velocities of all the bodies (in the order of the body list).
+   *
+   * Two worlds have the same hash if their bodies are bit-for-bit identical (-0 and 0 differ).
+   */
+  uint64_t world_hash(const b2World& world, uint64_t seed = 0);
+
+  /**
+   * @brief Hashes of the world recorded at some ticks of a run (see Simu::enable_state_hash).
+   *
+   * running() chains all the hashes, so two streams with the same running hash are (almost surely) identical.
+   */
+  class HashStream {
+  public:
+    struct Entry {
+      uint64_t tick;
+      uint64_t hash;
+    };
+
+    void push_back(uint64_t tick, uint64_t hash)
+    {
+      _entries.push_back({tick, hash});
+      _running = hash_mix(_running, hash);
+    }
+    void clear() { _entries.clear(); _running = 0; }
+    void reserve(size_t size) { _entries.reserve(size); }
+
+    size_t size() const { return _entries.size(); }
+    const Entry& operator[](size_t i) const { return _entries[i]; }
+    const std::vector<Entry>& entries() const { return _entries; }
+    uint64_t running() const { return _running; }
+
+    bool save(const std::string& filename) const;
+    bool load(const std::string& filename);
+
+  protected:
+    std::vector<Entry> _entries;
+    uint64_t _running = 0;
+  };
+
+  constexpr size_t no_divergence = std::numeric_limits<size_t>::max();
+
+  /**
+   * @brief First tick where two hash streams differ (different hash, or a tick missing in one of them).
+   *
+   * When one stream is a prefix of the other, there is no divergence.
+   */
+  size_t first_divergence(const HashStream& a, const HashStream& b);
+} // namespace robox2d
+
+#endif
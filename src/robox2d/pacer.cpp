@@ -0,0 +1,74 @@
+#include "pacer.hpp"
+
+#include <thread>
+
+namespace robox2d {
+
+  Pacer::Pacer(double rtf, double max_lag) :
+    _max_lag(max_lag),
+    _sim_start(0),
+    _last_sim(0)
+  {
+    set_real_time_factor(rtf);
+    start(0.0);
+  }
+
+  void Pacer::set_real_time_factor(double rtf)
+  {
+    _stats.target_rtf = rtf > 0 ? rtf : 0.0;
+    // the new factor applies from now on
+    start(_last_sim);
+  }
+
+  void Pacer::start(double sim_time)
+  {
+    _wall_start = clock::now();
+    _sim_start = sim_time;
+    _last_wall = _wall_start;
+    _last_sim = sim_time;
+  }
+
+  void Pacer::wait(double sim_time)
+  {
+    if (_stats.target_rtf > 0) {
+      auto target = _wall_start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>((sim_time - _sim_start) / _stats.target_rtf));
+      auto now = clock::now();
+      if (target > now) {
+	std::this_thread::sleep_until(target);
+	auto after = clock::now();
+	_stats.sleep_time += std::chrono::duration<double>(after - now).count();
+	_stats.nb_waits++;
+	now = after;
+      }
+      else if (std::chrono::duration<double>(now - target).count() > _max_lag) {
+	// too late: do not try to catch up
+	_wall_start = now;
+	_sim_start = sim_time;
+	_stats.nb_resyncs++;
+      }
+      _account(sim_time, now);
+    }
+    else
+      _account(sim_time, clock::now());
+  }
+
+  void Pacer::stop(double sim_time)
+  {
+    _account(sim_time, clock::now());
+  }
+
+  void Pacer::reset_stats()
+  {
+    double rtf = _stats.target_rtf;
+    _stats = PacingStats();
+    _stats.target_rtf = rtf;
+  }
+
+  void Pacer::_account(double sim_time, clock::time_point now)
+  {
+    _stats.simulated_time += sim_time - _last_sim;
+    _stats.wall_time += std::chrono::duration<double>(now - _last_wall).count();
+    _last_sim = sim_time;
+    _last_wall = now;
+  }
+} // namespace robox2d
@@ -0,0 +1,66 @@
+#ifndef ROBOX2D_PACER_HPP
+#define ROBOX2D_PACER_HPP
+
+#include <chrono>
+#include <cstddef>
+
+namespace robox2d {
+
+  /**
+   * @brief Statistics of the real-time pacing (see Pacer).
+   */
+  struct PacingStats {
+    double target_rtf = 1.0; // 0 means as fast as possible
+    double simulated_time = 0; // simulated time while paced
+    double wall_time = 0; // wall time while paced
+    double sleep_time = 0; // wall time spent sleeping
+    size_t nb_waits = 0;
+    size_t nb_resyncs = 0; // times the pacer was too late and restarted from the current time
+
+    double achieved_rtf() const { return wall_time > 0 ? simulated_time / wall_time : 0.0; }
+  };
+
+  /**
+   * @brief Keeps the simulated time at a given real-time factor of a monotonic clock.
+   *
+   * wait(t) sleeps until the wall time elapsed since start() reaches (t - t_start) / rtf, so the time spent in
+   * physics and rendering is part of the budget. When the simulation is late by more than max_lag seconds (of wall
+   * time), the pacer restarts from the current time instead of running as fast as possible to catch up.
+   */
+  class Pacer {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    Pacer(double rtf = 1.0, double max_lag = 0.1);
+
+    /* Real-time factor (2 runs twice as fast as real time); 0 (or less) runs as fast as possible */
+    void set_real_time_factor(double rtf);
+    double real_time_factor() const { return _stats.target_rtf; }
+
+    void set_max_lag(double max_lag) { _max_lag = max_lag; }
+    double max_lag() const { return _max_lag; }
+
+    /* Anchor the pacing: simulated time sim_time corresponds to now */
+    void start(double sim_time);
+    /* Sleep until the wall time of sim_time (returns immediately when late or without target) */
+    void wait(double sim_time);
+    /* Account the time since the last wait (end of a run) */
+    void stop(double sim_time);
+
+    const PacingStats& stats() const { return _stats; }
+    void reset_stats();
+
+  protected:
+    void _account(double sim_time, clock::time_point now);
+
+    PacingStats _stats;
+    double _max_lag;
+
+    clock::time_point _wall_start;
+    double _sim_start;
+    clock::time_point _last_wall;
+    double _last_sim;
+  };
+} // namespace robox2d
+
+#endif
@@ -0,0 +1,90 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+namespace robox2d {
+
+  const char* SimuStats::phase_name(size_t phase)
+  {
+    static const char* names[NbPhases] = {"control", "actuators", "world_step", "descriptors", "graphics", "physic_step", "sensors"};
+    return phase < NbPhases ? names[phase] : "unknown";
+  }
+
+  double SimuStats::step_percentile(double q) const
+  {
+    const PhaseStats& s = step();
+    if (s.count == 0)
+      return 0.0;
+    size_t rank = std::min(s.count - 1, static_cast<size_t>(q * s.count));
+    size_t seen = 0;
+    for (size_t b = 0; b < nb_buckets; b++) {
+      seen += step_histogram[b];
+      if (seen > rank)
+	return std::min(s.max, std::max(s.min, std::exp2((b + 1) / 8.0) * 1e-9));
+    }
+    return s.max;
+  }
+
+  void Profiler::set_tracing(bool tracing, size_t max_events)
+  {
+    _tracing = tracing;
+    _max_events = max_events;
+    if (tracing)
+      _events.reserve(max_events);
+  }
+
+  void Profiler::begin_run()
+  {
+    _run_start = clock::now();
+  }
+
+  void Profiler::end_run(double simulated_time)
+  {
+    _stats.simulated_time += simulated_time;
+    _stats.wall_time += std::chrono::duration<double>(clock::now() - _run_start).count();
+  }
+
+  void Profiler::record(SimuStats::Phase phase, clock::time_point start, clock::time_point end)
+  {
+    double duration = std::chrono::duration<double>(end - start).count();
+    auto& s = _stats.phases[phase];
+    s.min = s.count ? std::min(s.min, duration) : duration;
+    s.max = s.count ? std::max(s.max, duration) : duration;
+    s.total += duration;
+    s.count++;
+
+    if (phase == SimuStats::PhysicStep) {
+      double ns = std::max(1.0, duration * 1e9);
+      size_t bucket = std::min(SimuStats::nb_buckets - 1, static_cast<size_t>(8.0 * std::log2(ns)));
+      _stats.step_histogram[bucket]++;
+    }
+
+    if (_tracing && _events.size() < _max_events)
+      _events.push_back({phase, std::chrono::duration<double, std::micro>(start - _origin).count(), duration * 1e6});
+  }
+
+  void Profiler::reset()
+  {
+    _stats = SimuStats();
+    _events.clear();
+  }
+
+  bool Profiler::dump_trace(const std::string& filename) const
+  {
+    std::ofstream ofs(filename);
+    if (!ofs)
+      return false;
+    ofs << std::fixed << std::setprecision(3);
+    ofs << "{\"traceEvents\":[\n";
+    for (size_t i = 0; i < _events.size(); i++) {
+      const auto& e = _events[i];
+      ofs << "{\"name\":\"" << SimuStats::phase_name(e.phase) << "\",\"cat\":\"robox2d\",\"ph\":\"X\",\"pid\":0,\"tid\":0,"
+	  << "\"ts\":" << e.start << ",\"dur\":" << e.duration << "}" << (i + 1 < _events.size() ? ",\n" : "\n");
+    }
+    ofs << "],\"displayTimeUnit\":\"ns\"}\n";
+    return true;
+  }
+} // namespace robox2d
@@ -0,0 +1,106 @@
+#ifndef ROBOX2D_PROFILER_HPP
+#define ROBOX2D_PROFILER_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace robox2d {
+
+  /**
+   * @brief Statistics of the phases of Simu::run (times in seconds).
+   */
+  struct SimuStats {
+    enum Phase { Control = 0, Actuators, WorldStep, Descriptors, Graphics, PhysicStep, Sensors, NbPhases };
+    static const char* phase_name(size_t phase);
+
+    struct PhaseStats {
+      double total = 0;
+      size_t count = 0;
+      double min = 0;
+      double max = 0;
+
+      double mean() const { return count ? total / count : 0.0; }
+    };
+
+    std::array<PhaseStats, NbPhases> phases;
+
+    /* Latency of the physic steps (actuators + world step + descriptors) */
+    const PhaseStats& step() const { return phases[PhysicStep]; }
+    /* Percentile (q in [0, 1]) of the physic step latency, from a log-scale histogram (~10% resolution) */
+    double step_percentile(double q) const;
+
+    double simulated_time = 0;
+    double wall_time = 0; // time spent in Simu::run
+    double real_time_factor() const { return wall_time > 0 ? simulated_time / wall_time : 0.0; }
+
+    static const size_t nb_buckets = 256;
+    std::array<size_t, nb_buckets> step_histogram{}; // bucket b holds latencies in [2^(b/8), 2^((b+1)/8)) ns
+  };
+
+  /**
+   * @brief Profiler records the phases of Simu::run when enabled (see Simu::enable_profiling).
+   *
+   * The instrumentation of Simu::run is only compiled when ROBOX2D_PROFILING is defined (`./waf configure --profiling`).
+   */
+  class Profiler {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    class Scope {
+    public:
+      Scope(Profiler& profiler, SimuStats::Phase phase) : _profiler(profiler), _phase(phase), _active(profiler.enabled())
+      {
+	if (_active)
+	  _start = clock::now();
+      }
+      ~Scope()
+      {
+	if (_active)
+	  _profiler.record(_phase, _start, clock::now());
+      }
+
+    private:
+      Profiler& _profiler;
+      SimuStats::Phase _phase;
+      bool _active;
+      clock::time_point _start;
+    };
+
+    Profiler() : _origin(clock::now()) {}
+
+    bool enabled() const { return _enabled; }
+    void set_enabled(bool enabled) { _enabled = enabled; }
+    bool tracing() const { return _tracing; }
+    void set_tracing(bool tracing, size_t max_events = 1000000);
+
+    void begin_run();
+    void end_run(double simulated_time);
+    void record(SimuStats::Phase phase, clock::time_point start, clock::time_point end);
+
+    const SimuStats& stats() const { return _stats; }
+    void reset();
+
+    /* Write the recorded events in the Chrome trace-event format (chrome://tracing, Perfetto) */
+    bool dump_trace(const std::string& filename) const;
+
+  protected:
+    struct TraceEvent {
+      SimuStats::Phase phase;
+      double start; // us since _origin
+      double duration; // us
+    };
+
+    bool _enabled = false;
+    bool _tracing = false;
+    size_t _max_events = 0;
+    SimuStats _stats;
+    std::vector<TraceEvent> _events;
+    clock::time_point _origin;
+    clock::time_point _run_start;
+  };
+} // namespace robox2d
+
+#endif
@@ -0,0 +1,171 @@
+#include "rasterizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "gui/instance_builder.hpp"
+
+namespace robox2d {
+
+  Rasterizer::Rasterizer(size_t width, size_t height, float resolution, size_t channels) :
+    _width(width),
+    _height(height),
+    _channels(channels),
+    _resolution(resolution),
+    _data(width * height * channels, 0.0f)
+  {
+    assert(width > 0 && height > 0 && resolution > 0.0f && "Empty grid");
+    assert((channels == 1 || channels == 3) && "Only 1 (occupancy) or 3 (RGB) channels");
+    _rotation.SetIdentity();
+  }
+
+  void Rasterizer::set_view(const b2Vec2& center, float angle)
+  {
+    _center = center;
+    _rotation.Set(angle);
+  }
+
+  void Rasterizer::clear(const float* background)
+  {
+    if (!background || _channels == 1) {
+      std::fill(_data.begin(), _data.end(), background ? background[0] : 0.0f);
+      return;
+    }
+    for (size_t i = 0; i < _data.size(); i += _channels)
+      std::copy(background, background + _channels, _data.begin() + i);
+  }
+
+  b2Vec2 Rasterizer::to_grid(const b2Vec2& p) const
+  {
+    b2Vec2 local = b2MulT(_rotation, p - _center);
+    return {0.5f * _width + local.x * _resolution, 0.5f * _height - local.y * _resolution};
+  }
+
+  void Rasterizer::draw_world(b2World& world, const b2Body* ignore)
+  {
+    // AABB of the (rotated) grid
+    b2Vec2 half_x = (0.5f * _width / _resolution) * b2Vec2(_rotation.c, _rotation.s);
+    b2Vec2 half_y = (0.5f * _height / _resolution) * b2Vec2(-_rotation.s, _rotation.c);
+    b2Vec2 extent(std::abs(half_x.x) + std::abs(half_y.x), std::abs(half_x.y) + std::abs(half_y.y));
+    b2AABB aabb;
+    aabb.lowerBound = _center - extent;
+    aabb.upperBound = _center + extent;
+
+    _fixtures.clear();
+    QueryCallback query;
+    query.fixtures = &_fixtures;
+    world.QueryAABB(&query, aabb);
+
+    using gui::InstanceBuilder;
+    static const float occupied[1] = {1.0f};
+    const std::array<float, 3> box_color = InstanceBuilder::default_color(InstanceBuilder::Box);
+    const std::array<float, 3> circle_color = InstanceBuilder::default_color(InstanceBuilder::Circle);
+    _nb_drawn = 0;
+    for (b2Fixture* fixture : _fixtures) {
+      if (fixture->GetBody() == ignore)
+	continue;
+      const float* value = occupied;
+      if (_channels == 3)
+	value = fixture->GetType() == b2Shape::e_circle ? circle_color.data() : box_color.data();
+      draw_fixture(fixture, value);
+      _nb_drawn++;
+    }
+  }
+
+  void Rasterizer::draw_fixture(b2Fixture* fixture, const float* value)
+  {
+    const b2Transform& xf = fixture->GetBody()->GetTransform();
+    switch (fixture->GetType())
+      {
+      case b2Shape::e_circle:
+	{
+	  const b2CircleShape* circle = static_cast<const b2CircleShape*>(fixture->GetShape());
+	  fill_circle(to_grid(b2Mul(xf, circle->m_p)), circle->m_radius * _resolution, value);
+	  break;
+	}
+      case b2Shape::e_polygon:
+	{
+	  const b2PolygonShape* poly = static_cast<const b2PolygonShape*>(fixture->GetShape());
+	  b2Vec2 points[b2_maxPolygonVertices];
+	  for (int32 i = 0; i < poly->m_count; i++)
+	    points[i] = to_grid(b2Mul(xf, poly->m_vertices[i]));
+	  fill_polygon(points, poly->m_count, value);
+	  break;
+	}
+      default: // edges and chains have no area
+	break;
+      }
+  }
+
+  void Rasterizer::fill_polygon(const b2Vec2* points, size_t count, const float* value)
+  {
+    float min_y = points[0].y, max_y = points[0].y;
+    for (size_t i = 1; i < count; i++) {
+      min_y = std::min(min_y, points[i].y);
+      max_y = std::max(max_y, points[i].y);
+    }
+    // rows whose center (row + 0.5) is inside [min_y, max_y]
+    long y0 = std::max(0L, (long)std::ceil(min_y - 0.5f));
+    long y1 = std::min((long)_height - 1, (long)std::floor(max_y - 0.5f));
+    for (long y = y0; y <= y1; y++) {
+      const float yc = y + 0.5f;
+      // convex polygon: the row crosses it on one span, bounded by the crossed edges
+      float left = _width, right = -1.0f;
+      for (size_t i = 0, j = count - 1; i < count; j = i++) {
+	const b2Vec2& a = points[j];
+	const b2Vec2& b = points[i];
+	if ((a.y <= yc) == (b.y <= yc))
+	  continue;
+	float x = a.x + (yc - a.y) * (b.x - a.x) / (b.y - a.y);
+	left = std::min(left, x);
+	right = std::max(right, x);
+      }
+      _fill_span(y, (long)std::ceil(left - 0.5f), (long)std::floor(right - 0.5f), value);
+    }
+  }
+
+  void Rasterizer::fill_circle(const b2Vec2& center, float radius, const float* value)
+  {
+    long y0 = std::max(0L, (long)std::ceil(center.y - radius - 0.5f));
+    long y1 = std::min((long)_height - 1, (long)std::floor(center.y + radius - 0.5f));
+    const float r2 = radius * radius;
+    for (long y = y0; y <= y1; y++) {
+      float dy = y + 0.5f - center.y;
+      float dx = std::sqrt(std::max(0.0f, r2 - dy * dy));
+      _fill_span(y, (long)std::ceil(center.x - dx - 0.5f), (long)std::floor(center.x + dx - 0.5f), value);
+    }
+  }
+
+  void Rasterizer::_fill_span(size_t row, long x0, long x1, const float* value)
+  {
+    x0 = std::max(x0, 0L);
+    x1 = std::min(x1, (long)_width - 1);
+    if (x0 > x1)
+      return;
+    float* p = data(row) + x0 * _channels;
+    const size_t n = x1 - x0 + 1;
+    // contiguous stores of constant values, vectorized by the compiler
+    if (_channels == 1) {
+      const float v = value[0];
+      for (size_t i = 0; i < n; i++)
+	p[i] = v;
+    }
+    else {
+      const float r = value[0], g = value[1], b = value[2];
+      for (size_t i = 0; i < n; i++) {
+	p[3 * i] = r;
+	p[3 * i + 1] = g;
+	p[3 * i + 2] = b;
+      }
+    }
+  }
+
+  bool Rasterizer::QueryCallback::ReportFixture(b2Fixture* fixture)
+  {
+    b2Shape::Type type = fixture->GetType();
+    if (!fixture->IsSensor() && (type == b2Shape::e_circle || type == b2Shape::e_polygon))
+      fixtures->push_back(fixture);
+    return true;
+  }
+} // namespace robox2d
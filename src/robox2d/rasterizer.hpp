@@ -0,0 +1,73 @@
+#ifndef ROBOX2D_RASTERIZER_HPP
+#define ROBOX2D_RASTERIZER_HPP
+
+#include <vector>
+
+#include <box2d/box2d.h>
+
+namespace robox2d {
+
+  /**
+   * @brief CPU rasterizer of the fixtures of a world into a small grid (no OpenGL).
+   *
+   * The grid covers width x height cells of 1/resolution meters around a view center, and can be rotated
+   * (the x axis of the view points to the right of the grid, row 0 is the top). Each cell holds channels floats.
+   *
+   * draw_world() finds the fixtures overlapping the grid with b2World::QueryAABB and fills them row by row
+   * (scanlines): convex polygons (boxes included) and circles; edges and chains are not drawn. A cell is filled
+   * when its center is inside the shape. With 1 channel the fixtures are drawn with 1 (occupancy), with 3 channels
+   * with the colors of the renderer (see gui::InstanceBuilder::default_color).
+   */
+  class Rasterizer {
+  public:
+    Rasterizer(size_t width, size_t height, float resolution, size_t channels = 1);
+
+    /* Center of the grid and orientation of its x axis (world frame) */
+    void set_view(const b2Vec2& center, float angle = 0.0f);
+
+    /* Fill all the cells with background (channels values, 0 if nullptr) */
+    void clear(const float* background = nullptr);
+
+    /* Draw the fixtures overlapping the grid (except the ones of ignore and the sensor fixtures) */
+    void draw_world(b2World& world, const b2Body* ignore = nullptr);
+    /* Draw one fixture with value (channels values) */
+    void draw_fixture(b2Fixture* fixture, const float* value);
+
+    /* Fill shapes given in grid coordinates (cells, x to the right, y down) */
+    void fill_polygon(const b2Vec2* points, size_t count, const float* value);
+    void fill_circle(const b2Vec2& center, float radius, const float* value);
+
+    /* World point to grid coordinates */
+    b2Vec2 to_grid(const b2Vec2& p) const;
+
+    size_t width() const { return _width; }
+    size_t height() const { return _height; }
+    size_t channels() const { return _channels; }
+    float resolution() const { return _resolution; }
+    /* Cells row by row, channels values per cell */
+    const std::vector<float>& data() const { return _data; }
+    float* data(size_t row) { return _data.data() + row * _width * _channels; }
+
+    /* Fixtures drawn by the last draw_world */
+    size_t nb_drawn() const { return _nb_drawn; }
+
+  protected:
+    void _fill_span(size_t row, long x0, long x1, const float* value);
+
+    struct QueryCallback : public b2QueryCallback {
+      bool ReportFixture(b2Fixture* fixture) override;
+
+      std::vector<b2Fixture*>* fixtures = nullptr;
+    };
+
+    size_t _width, _height, _channels;
+    float _resolution;
+    b2Vec2 _center = {0.0f, 0.0f};
+    b2Rot _rotation;
+    std::vector<float> _data;
+    std::vector<b2Fixture*> _fixtures;
+    size_t _nb_drawn = 0;
+  };
+} // namespace robox2d
+
+#endif
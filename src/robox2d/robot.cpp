@@ -1,33 +1,328 @@
 #include "robot.hpp"
 #include "control/base_controller.hpp"
 
+#include <algorithm>
 #include <unistd.h>
 #include <iostream>
+#include <cassert>
+#include <typeinfo>
 
 namespace robox2d {
   
-  std::shared_ptr<Robot> Robot::clone() const
+  std::shared_ptr<Robot> Robot::clone(CloneMap& map) const
   {
-    //return robot;
+    // a copy as a plain Robot would lose the members of the derived class
+    assert(typeid(*this) == typeid(Robot) && "Robots deriving from Robot must override clone (see _clone_as)");
+    return _clone_as<Robot>(map);
+  }
+
+  void Robot::_clone_components(CloneMap& map)
+  {
+    _banks_valid = false;
+    for (auto& a : _actuators) {
+      a = a->clone(map);
+      assert(a && "Actuator does not support cloning");
+    }
+    for (auto& ctrl : _controllers) {
+      auto copy = ctrl->clone();
+      if (copy)
+	ctrl = copy;
+    }
+    if (_default_bodies) {
+      _bodies.clear();
+      _joints.clear();
+    }
+    for (auto& b : _bodies)
+      b = map.body(b);
+    for (auto& j : _joints) {
+      j = map.joint(j);
+      assert(j && "Joint type not supported by CloneMap");
+    }
+    _state_layout_valid = false;
+    _state_cache = nullptr; // set again when the copy is added to a simu
+    _sensors_valid = false;
+    for (auto& s : _sensors) {
+      s = s->clone(map);
+      assert(s && "Sensor does not support cloning");
+    }
   }
   
   void Robot::control_update(double t)
   {
-    Eigen::VectorXd commands = Eigen::VectorXd::Zero(nb_dofs());
-    for (auto& ctrl : _controllers) {
-      commands += ctrl->commands(t, this);
+    // the buffers are only allocated at the first update (or if the number of actuators changed)
+    if ((size_t)_commands.size() != nb_dofs()) {
+      _commands.resize(nb_dofs());
+      _controller_commands.resize(nb_dofs());
+    }
+
+    if (_controllers.size() == 1)
+      _controllers[0]->write_commands(t, this, _commands);
+    else {
+      _commands.setZero();
+      for (auto& ctrl : _controllers) {
+	ctrl->write_commands(t, this, _controller_commands);
+	_commands += _controller_commands;
+      }
     }
 
     for(size_t i = 0; i<nb_dofs(); i++)
-      _actuators[i]->set_input(commands[i]);
+      _actuators[i]->set_input(_commands[i]);
   }
 
   void Robot::physic_update()
   {
-    for(auto s : _actuators)
+    if (!_use_banks) {
+      for(auto& s : _actuators)
+	s->update();
+      return;
+    }
+
+    // actuators are usually added in the constructor of the robot: the banks are built at the first update
+    if (!_banks_valid || _banked_nb_actuators != _actuators.size())
+      _build_banks();
+
+    _servo_bank.update();
+    for(auto s : _unbanked_actuators)
       s->update();
   }
 
+  void Robot::sensor_update()
+  {
+    if (_sensors.empty())
+      return;
+    if (!_sensors_valid)
+      _build_sensors();
+
+    _ray_batch.cast();
+    for (size_t i : _unbatched_sensors)
+      _sensors[i]->update(_observations.data() + _observation_offsets[i]);
+  }
+
+  void Robot::_build_sensors()
+  {
+    _observation_offsets.resize(_sensors.size());
+    size_t size = 0;
+    for (size_t i = 0; i < _sensors.size(); i++) {
+      _observation_offsets[i] = size;
+      size += _sensors[i]->size();
+    }
+    _observations = Eigen::VectorXd::Zero(size);
+
+    _ray_batch.clear();
+    _unbatched_sensors.clear();
+    for (size_t i = 0; i < _sensors.size(); i++) {
+      auto ray_sensor = dynamic_cast<sensor::RaySensor*>(_sensors[i].get());
+      if (ray_sensor)
+	_ray_batch.add(ray_sensor, _observations.data() + _observation_offsets[i]);
+      else
+	_unbatched_sensors.push_back(i);
+    }
+    _sensors_valid = true;
+  }
+
+  void Robot::add_body(b2Body* body)
+  {
+    if (_default_bodies) {
+      _bodies.clear();
+      _joints.clear();
+      _default_bodies = false;
+    }
+    _bodies.push_back(body);
+    _state_layout_valid = false;
+  }
+
+  void Robot::add_joint(b2Joint* joint)
+  {
+    if (_default_bodies) {
+      _bodies.clear();
+      _joints.clear();
+      _default_bodies = false;
+    }
+    _joints.push_back(joint);
+    _state_layout_valid = false;
+  }
+
+  void Robot::_build_state_layout() const
+  {
+    if (_default_bodies || (_bodies.empty() && _joints.empty())) {
+      // joints of the servos and the bodies they connect
+      _bodies.clear();
+      _joints.clear();
+      for (auto& a : _actuators) {
+	auto servo = dynamic_cast<const actuator::Servo*>(a.get());
+	if (!servo)
+	  continue;
+	b2Joint* joint = const_cast<b2RevoluteJoint*>(servo->get_joint());
+	_joints.push_back(joint);
+	for (b2Body* b : {joint->GetBodyA(), joint->GetBodyB()})
+	  if (std::find(_bodies.begin(), _bodies.end(), b) == _bodies.end())
+	    _bodies.push_back(b);
+      }
+      _default_bodies = true;
+      _state_nb_actuators = _actuators.size();
+    }
+
+    const size_t nj = _joints.size(), nb = _bodies.size();
+    _positions = 0;
+    _velocities = nj;
+    _forces = 2 * nj;
+    _poses = 3 * nj;
+    _body_velocities = 3 * nj + 3 * nb;
+    _com = 3 * nj + 6 * nb;
+    _state = Eigen::VectorXd::Zero(_com + 4);
+    _state_layout_valid = true;
+    _state_valid = false;
+  }
+
+  void Robot::_refresh_state() const
+  {
+    double* state = _state.data();
+    const float inv_dt = _inv_dt;
+    for (size_t i = 0; i < _joints.size(); i++) {
+      double q = 0.0, dq = 0.0, f = 0.0;
+      b2Joint* joint = _joints[i];
+      switch (joint->GetType()) {
+      case e_revoluteJoint:
+	{
+	  auto j = static_cast<b2RevoluteJoint*>(joint);
+	  q = j->GetJointAngle();
+	  dq = j->GetJointSpeed();
+	  f = j->GetMotorTorque(inv_dt);
+	  break;
+	}
+      case e_prismaticJoint:
+	{
+	  auto j = static_cast<b2PrismaticJoint*>(joint);
+	  q = j->GetJointTranslation();
+	  dq = j->GetJointSpeed();
+	  f = j->GetMotorForce(inv_dt);
+	  break;
+	}
+      case e_wheelJoint:
+	{
+	  auto j = static_cast<b2WheelJoint*>(joint);
+	  q = j->GetJointAngle();
+	  dq = j->GetJointAngularSpeed();
+	  f = j->GetMotorTorque(inv_dt);
+	  break;
+	}
+      default:
+	break;
+      }
+      state[_positions + i] = q;
+      state[_velocities + i] = dq;
+      state[_forces + i] = f;
+    }
+
+    // Gathering the whole world costs more than reading a few bodies: the world state is only used when it is
+    // already gathered (for another robot or a descriptor) or when the robot has a large part of the bodies
+    const WorldState* ws = nullptr;
+    if (_state_cache && !_bodies.empty()
+	&& (_state_cache->valid() || 4 * _bodies.size() >= size_t(_bodies[0]->GetWorld()->GetBodyCount())))
+      ws = &_state_cache->get();
+    if (ws && (_body_indices.size() != _bodies.size() || _body_indices_version != ws->version)) {
+      _body_indices.resize(_bodies.size());
+      for (size_t i = 0; i < _bodies.size(); i++)
+	_body_indices[i] = _state_cache->index(_bodies[i]);
+      _body_indices_version = ws->version;
+    }
+
+    double mass = 0.0, cx = 0.0, cy = 0.0, vx = 0.0, vy = 0.0;
+    for (size_t i = 0; i < _bodies.size(); i++) {
+      double* pose = state + _poses + 3 * i;
+      double* vel = state + _body_velocities + 3 * i;
+      double m, c_x, c_y;
+      const size_t j = ws ? _body_indices[i] : WorldStateCache::npos;
+      if (j != WorldStateCache::npos) {
+	pose[0] = ws->x[j];
+	pose[1] = ws->y[j];
+	pose[2] = ws->angle[j];
+	vel[0] = ws->vx[j];
+	vel[1] = ws->vy[j];
+	vel[2] = ws->w[j];
+	m = ws->mass[j];
+	c_x = ws->cx[j];
+	c_y = ws->cy[j];
+      }
+      else {
+	const b2Body* body = _bodies[i];
+	const b2Transform& xf = body->GetTransform();
+	const b2Vec2& v = body->GetLinearVelocity();
+	const b2Vec2& c = body->GetWorldCenter();
+	pose[0] = xf.p.x;
+	pose[1] = xf.p.y;
+	pose[2] = body->GetAngle();
+	vel[0] = v.x;
+	vel[1] = v.y;
+	vel[2] = body->GetAngularVelocity();
+	m = body->GetMass();
+	c_x = c.x;
+	c_y = c.y;
+      }
+      mass += m;
+      cx += m * c_x;
+      cy += m * c_y;
+      vx += m * vel[0];
+      vy += m * vel[1];
+    }
+    // static bodies have no mass: the com is then the one of the dynamic bodies (0 if there is none)
+    double* com = state + _com;
+    com[0] = mass > 0.0 ? cx / mass : 0.0;
+    com[1] = mass > 0.0 ? cy / mass : 0.0;
+    com[2] = mass > 0.0 ? vx / mass : 0.0;
+    com[3] = mass > 0.0 ? vy / mass : 0.0;
+    _state_valid = true;
+  }
+
+  void Robot::_build_banks()
+  {
+    _servo_bank.clear();
+    _unbanked_actuators.clear();
+    for (auto& a : _actuators) {
+      // derived classes of Servo may have their own update()
+      if (typeid(*a) == typeid(actuator::Servo))
+	_servo_bank.add(std::static_pointer_cast<actuator::Servo>(a));
+      else
+	_unbanked_actuators.push_back(a.get());
+    }
+    _banked_nb_actuators = _actuators.size();
+    _banks_valid = true;
+  }
+
+  size_t Robot::state_size() const
+  {
+    size_t size = 0;
+    for (auto& a : _actuators)
+      size += a->state_size();
+    for (auto& ctrl : _controllers)
+      size += ctrl->state_size();
+    return size;
+  }
+
+  void Robot::save_state(double* state) const
+  {
+    for (auto& a : _actuators) {
+      a->save_state(state);
+      state += a->state_size();
+    }
+    for (auto& ctrl : _controllers) {
+      ctrl->save_state(state);
+      state += ctrl->state_size();
+    }
+  }
+
+  void Robot::load_state(const double* state)
+  {
+    for (auto& a : _actuators) {
+      a->load_state(state);
+      state += a->state_size();
+    }
+    for (auto& ctrl : _controllers) {
+      ctrl->load_state(state);
+      state += ctrl->state_size();
+    }
+  }
+
     void Robot::remove_controller(const std::shared_ptr<control::BaseController>& controller)
     {
         auto it = std::find(_controllers.begin(), _controllers.end(), controller);
@@ -5,7 +5,12 @@
 #include<memory>
 #include<vector>
 
+#include <Eigen/Core>
+
 #include "actuator.hpp"
+#include "actuator_bank.hpp"
+#include "sensor.hpp"
+#include "world_state.hpp"
 #include "control/base_controller.hpp"
 
 namespace robox2d {
@@ -15,11 +20,28 @@ namespace robox2d {
   public:
     
     //Robot(std::shared_ptr<b2World> world){ }
-    
-    std::shared_ptr<Robot> clone() const;
+    virtual ~Robot() {}
+
+    /**
+     * @brief Deep copy of the robot in the world of map (bodies, fixtures, joints, actuators and controllers).
+     *
+     * Classes deriving from Robot must override it (the default asserts the robot is a plain Robot), e.g. with
+     * `auto copy = _clone_as<MyRobot>(map);` and then rebind their bodies/joints with map.body()/map.joint().
+     */
+    virtual std::shared_ptr<Robot> clone(CloneMap& map) const;
         
     void physic_update();
     void control_update(double t);
+    /* Update the sensors and their observations (called by Simu::run before the control updates) */
+    void sensor_update();
+
+    /* Commands sent to the actuators at the last control update */
+    const Eigen::VectorXd& commands() const { return _commands; }
+
+    /* Internal state of the actuators and controllers (used by Simu::snapshot/restore) */
+    size_t state_size() const;
+    void save_state(double* state) const;
+    void load_state(const double* state);
 
 
     
@@ -35,43 +57,134 @@ namespace robox2d {
     void remove_controller(const std::shared_ptr<control::BaseController>& controller);
     void remove_controller(size_t index);
     void clear_controllers();
+    const std::vector<std::shared_ptr<control::BaseController>>& controllers() const { return _controllers; }
     
     
      
+    /* Sensors of the robot; the ray sensors are cast as one batch (see sensor::RayBatch) */
+    void add_sensor(const std::shared_ptr<sensor::Sensor>& sensor) { _sensors.push_back(sensor); _sensors_valid = false; }
+    const std::vector<std::shared_ptr<sensor::Sensor>>& sensors() const { return _sensors; }
+    void clear_sensors() { _sensors.clear(); _sensors_valid = false; }
+
+    /* Measures of all the sensors, in the order they were added (contiguous) */
+    const Eigen::VectorXd& observations() const { return _observations; }
+    /* Measures of one sensor */
+    Eigen::VectorXd::ConstSegmentReturnType observation(size_t sensor) const { return _observations.segment(_observation_offsets[sensor], _sensors[sensor]->size()); }
+
+    /* Update the servos of the robot as a bank (see actuator::ServoBank), enabled by default */
+    void enable_actuator_banks(bool enable) { _use_banks = enable; _banks_valid = false; }
+    bool actuator_banks_enabled() const { return _use_banks; }
+
+    /* Set the tolerance of all the actuators (see actuator::Actuator::set_tolerance for the units) */
+    void set_actuator_tolerance(double tolerance) { for (auto& a : _actuators) a->set_tolerance(tolerance); }
+
     //size_t num_dofs() const;
     size_t nb_dofs() const {return _actuators.size();};
-    //size_t num_bodies() const;
-    /*
-    Eigen::Vector3d com() const;
-    Eigen::Vector6d com_velocity() const;
-    Eigen::Vector6d com_acceleration() const;
-    
-    Eigen::VectorXd positions() const;
-    void set_positions(const Eigen::VectorXd& positions);
-    
-    Eigen::VectorXd velocities() const;
-    void set_velocities(const Eigen::VectorXd& velocities);
-    
-    Eigen::VectorXd accelerations() const;
-    void set_accelerations(const Eigen::VectorXd& accelerations);
-    
-    Eigen::VectorXd forces() const;
-    void set_forces(const Eigen::VectorXd& forces);
-    
-    std::pair<Eigen::Vector6d, Eigen::Vector6d> force_torque(size_t joint_index) const;
-    
-    
-    Eigen::Isometry3d body_pose(const std::string& body_name) const;
-    Eigen::Isometry3d body_pose(size_t body_index) const;
-    
-    std::vector<std::string> body_names() const;
-    std::string body_name(size_t body_index) const;
-    void set_body_name(size_t body_index, const std::string& body_name);
-    */
+
+    // State of the robot
+
+    /**
+     * @brief Bodies and joints of the robot, registered by the constructors of the robots.
+     *
+     * When none is registered, the joints are the ones of the servos and the bodies the ones they connect.
+     */
+    void add_body(b2Body* body);
+    void add_joint(b2Joint* joint);
+    size_t nb_bodies() const { _check_state(); return _bodies.size(); }
+    size_t nb_joints() const { _check_state(); return _joints.size(); }
+    b2Body* body(size_t index) const { _check_state(); return _bodies[index]; }
+    b2Joint* joint(size_t index) const { _check_state(); return _joints[index]; }
+
+    /**
+     * @brief Views on the state of the bodies and joints, read at most once per physic step.
+     *
+     * The state is gathered in one buffer at the first access after a step (Simu::run invalidates it after each
+     * physic step), so the accessors neither allocate nor walk the world. The views stay valid until bodies or
+     * joints are added. Outside of Simu::run, call invalidate_state() after changing the world.
+     */
+    /* Joint positions: angles of revolute and wheel joints, translations of prismatic joints (0 for the others) */
+    Eigen::Map<const Eigen::VectorXd> positions() const { return _state_segment(_positions, _joints.size()); }
+    Eigen::Map<const Eigen::VectorXd> velocities() const { return _state_segment(_velocities, _joints.size()); }
+    /* Motor torques (revolute, wheel) or forces (prismatic) applied during the last step */
+    Eigen::Map<const Eigen::VectorXd> forces() const { return _state_segment(_forces, _joints.size()); }
+
+    /* Pose (x, y, angle of the body origin) and velocity (vx, vy, angular velocity) of the bodies, one column per body */
+    Eigen::Map<const Eigen::Matrix3Xd> body_poses() const { _check_state(); return {_state.data() + _poses, 3, Eigen::Index(_bodies.size())}; }
+    Eigen::Map<const Eigen::Matrix3Xd> body_velocities() const { _check_state(); return {_state.data() + _body_velocities, 3, Eigen::Index(_bodies.size())}; }
+    Eigen::Map<const Eigen::Vector3d> body_pose(size_t index) const { _check_state(); return Eigen::Map<const Eigen::Vector3d>(_state.data() + _poses + 3 * index); }
+    Eigen::Map<const Eigen::Vector3d> body_velocity(size_t index) const { _check_state(); return Eigen::Map<const Eigen::Vector3d>(_state.data() + _body_velocities + 3 * index); }
+
+    /* Center of mass of the bodies and its velocity */
+    Eigen::Map<const Eigen::Vector2d> com() const { _check_state(); return Eigen::Map<const Eigen::Vector2d>(_state.data() + _com); }
+    Eigen::Map<const Eigen::Vector2d> com_velocity() const { _check_state(); return Eigen::Map<const Eigen::Vector2d>(_state.data() + _com + 2); }
+
+    /* Mark the state as outdated (inv_dt: inverse of the last time step, used for the joint forces) */
+    void invalidate_state(double inv_dt = 0.0) { _state_valid = false; if (inv_dt > 0.0) _inv_dt = inv_dt; }
+    /* Read the bodies from the world state of the simu (set by Simu::add_robot; nullptr: read the bodies directly).
+       The state is gathered for the robot only if it has at least a quarter of the bodies of the world. */
+    void set_state_cache(const WorldStateCache* cache) { _state_cache = cache; _state_valid = false; }
     
   protected:
+    /* Rebind the actuators of a copy to the cloned world and copy the stateful controllers */
+    void _clone_components(CloneMap& map);
+    /* Sort the actuators between the banks and the ones updated one by one */
+    void _build_banks();
+    /* Place the sensors in the observation buffer and gather the ray sensors in a batch */
+    void _build_sensors();
+    /* Refresh the state buffer if needed (and its layout if bodies or joints were added) */
+    void _check_state() const
+    {
+      if (!_state_layout_valid || (_default_bodies && _state_nb_actuators != _actuators.size()))
+	_build_state_layout();
+      if (!_state_valid)
+	_refresh_state();
+    }
+    void _build_state_layout() const;
+    void _refresh_state() const;
+    Eigen::Map<const Eigen::VectorXd> _state_segment(size_t offset, size_t size) const { _check_state(); return {_state.data() + offset, Eigen::Index(size)}; }
+
+    template <typename T>
+    std::shared_ptr<T> _clone_as(CloneMap& map) const
+    {
+      auto robot = std::make_shared<T>(static_cast<const T&>(*this));
+      robot->_clone_components(map);
+      return robot;
+    }
+
     std::vector<std::shared_ptr<actuator::Actuator>> _actuators;
     std::vector<std::shared_ptr<control::BaseController>> _controllers;
+
+    bool _use_banks = true;
+    bool _banks_valid = false;
+    size_t _banked_nb_actuators = 0; // _actuators.size() when the banks were built
+    actuator::ServoBank _servo_bank;
+    std::vector<actuator::Actuator*> _unbanked_actuators;
+
+    // registered (mutable: filled with the default bodies and joints at the first access)
+    mutable std::vector<b2Body*> _bodies;
+    mutable std::vector<b2Joint*> _joints;
+    mutable bool _default_bodies = false; // _bodies and _joints come from the servos
+    mutable size_t _state_nb_actuators = 0; // _actuators.size() when the default bodies were found
+    // state buffer: positions, velocities, forces, poses, body velocities, com and com velocity
+    mutable Eigen::VectorXd _state;
+    mutable bool _state_layout_valid = false;
+    mutable bool _state_valid = false;
+    mutable size_t _positions = 0, _velocities = 0, _forces = 0, _poses = 0, _body_velocities = 0, _com = 0;
+    double _inv_dt = 0.0;
+    const WorldStateCache* _state_cache = nullptr;
+    mutable std::vector<size_t> _body_indices; // index of the bodies in the world state
+    mutable size_t _body_indices_version = 0;
+
+    std::vector<std::shared_ptr<sensor::Sensor>> _sensors;
+    bool _sensors_valid = false;
+    std::vector<size_t> _observation_offsets;
+    std::vector<size_t> _unbatched_sensors;
+    sensor::RayBatch _ray_batch;
+    Eigen::VectorXd _observations;
+
+    // buffers reused at every control update
+    Eigen::VectorXd _commands;
+    Eigen::VectorXd _controller_commands;
   };
 } // namespace robot_dart
 
@@ -0,0 +1,180 @@
+#include "sensor.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace robox2d {
+  namespace sensor {
+
+    RaySensor::RaySensor(b2Body* body, const b2Vec2& anchor, const std::vector<float>& angles, float max_range) :
+      _body(body),
+      _anchor(anchor),
+      _angles(angles),
+      _max_range(max_range)
+    {
+      assert(max_range > 0.0f && "The range of a ray sensor must be positive");
+      for (float a : _angles)
+	_directions.push_back({std::cos(a), std::sin(a)});
+    }
+
+    void RaySensor::update(double* obs)
+    {
+      RayBatch batch;
+      batch.add(this, obs);
+      batch.cast();
+    }
+
+    std::shared_ptr<Sensor> RaySensor::clone(CloneMap& map) const
+    {
+      auto sensor = std::make_shared<RaySensor>(*this);
+      sensor->_body = map.body(_body);
+      return sensor;
+    }
+
+    Lidar::Lidar(b2Body* body, const b2Vec2& anchor, size_t nb_rays, float fov, float max_range, float angle) :
+      RaySensor(body, anchor, _spread(nb_rays, fov, angle), max_range)
+    {
+    }
+
+    std::vector<float> Lidar::_spread(size_t nb_rays, float fov, float angle)
+    {
+      assert(nb_rays > 0 && "A lidar needs at least one ray");
+      std::vector<float> angles(nb_rays, angle);
+      if (nb_rays == 1)
+	return angles;
+      // a full circle would cast the first and the last rays in the same direction
+      bool full = fov >= 2.0f * b2_pi - 1e-6f;
+      float step = full ? fov / nb_rays : fov / (nb_rays - 1);
+      for (size_t i = 0; i < nb_rays; i++)
+	angles[i] = angle - 0.5f * fov + i * step;
+      return angles;
+    }
+
+    GridSensor::GridSensor(b2Body* body, size_t width, size_t height, float resolution, size_t channels, bool egocentric) :
+      _body(body),
+      _egocentric(egocentric),
+      _rasterizer(width, height, resolution, channels)
+    {
+    }
+
+    void GridSensor::update(double* obs)
+    {
+      _rasterizer.set_view(_body->GetPosition(), _egocentric ? _body->GetAngle() : 0.0f);
+      _rasterizer.clear();
+      _rasterizer.draw_world(*_body->GetWorld(), _body);
+      const std::vector<float>& data = _rasterizer.data();
+      std::copy(data.begin(), data.end(), obs);
+    }
+
+    std::shared_ptr<Sensor> GridSensor::clone(CloneMap& map) const
+    {
+      auto sensor = std::make_shared<GridSensor>(*this);
+      sensor->_body = map.body(_body);
+      return sensor;
+    }
+
+    void RayBatch::add(RaySensor* sensor, double* obs)
+    {
+      _sensors.push_back({sensor, obs});
+      _nb_rays += sensor->size();
+    }
+
+    namespace {
+      /* Does the segment p1 + t * d, t in [0, max_fraction], cross the box? (slab test) */
+      inline bool segment_overlaps(const b2AABB& box, const b2Vec2& p1, const b2Vec2& d, float max_fraction)
+      {
+	float tmin = 0.0f, tmax = max_fraction;
+	for (int i = 0; i < 2; i++) {
+	  float p = p1(i), di = d(i), lo = box.lowerBound(i), hi = box.upperBound(i);
+	  if (std::abs(di) < b2_epsilon) {
+	    if (p < lo || p > hi)
+	      return false;
+	    continue;
+	  }
+	  float inv = 1.0f / di;
+	  float t1 = (lo - p) * inv, t2 = (hi - p) * inv;
+	  if (t1 > t2)
+	    std::swap(t1, t2);
+	  tmin = std::max(tmin, t1);
+	  tmax = std::min(tmax, t2);
+	  if (tmin > tmax)
+	    return false;
+	}
+	return true;
+      }
+    }
+
+    void RayBatch::cast()
+    {
+      if (_sensors.empty())
+	return;
+
+      // rays in world coordinates and their bounding box
+      _p1.resize(_nb_rays);
+      _p2.resize(_nb_rays);
+      b2AABB bounds;
+      bounds.lowerBound = bounds.upperBound = b2Mul(_sensors[0].sensor->body()->GetTransform(), _sensors[0].sensor->anchor());
+      size_t r = 0;
+      for (auto& e : _sensors) {
+	const RaySensor& s = *e.sensor;
+	const b2Transform& xf = s.body()->GetTransform();
+	b2Vec2 origin = b2Mul(xf, s.anchor());
+	for (const b2Vec2& dir : s.directions()) {
+	  b2Vec2 d = b2Mul(xf.q, dir);
+	  _p1[r] = origin;
+	  _p2[r] = origin + s.max_range() * d;
+	  bounds.lowerBound = b2Min(bounds.lowerBound, b2Min(_p1[r], _p2[r]));
+	  bounds.upperBound = b2Max(bounds.upperBound, b2Max(_p1[r], _p2[r]));
+	  r++;
+	}
+      }
+
+      // one traversal of the dynamic tree for the whole batch
+      _candidates.clear();
+      _query.candidates = &_candidates;
+      _sensors[0].sensor->body()->GetWorld()->QueryAABB(&_query, bounds);
+
+      r = 0;
+      for (auto& e : _sensors) {
+	const RaySensor& s = *e.sensor;
+	for (size_t k = 0; k < s.size(); k++, r++) {
+	  b2RayCastInput input;
+	  input.p1 = _p1[r];
+	  input.p2 = _p2[r];
+	  input.maxFraction = 1.0f;
+	  const b2Vec2 d = _p2[r] - _p1[r];
+	  for (const Candidate& c : _candidates) {
+	    if (c.fixture->GetBody() == s.body() || !(c.fixture->GetFilterData().categoryBits & s.mask_bits()))
+	      continue;
+	    // early-out: only the fixtures closer than the closest hit so far
+	    if (!segment_overlaps(c.aabb, input.p1, d, input.maxFraction))
+	      continue;
+	    b2RayCastOutput output;
+	    if (c.fixture->RayCast(&output, input, c.child) && output.fraction < input.maxFraction)
+	      input.maxFraction = output.fraction;
+	  }
+	  e.obs[k] = input.maxFraction * s.max_range();
+	}
+      }
+    }
+
+    bool RayBatch::QueryCallback::ReportFixture(b2Fixture* fixture)
+    {
+      if (fixture->IsSensor())
+	return true;
+      int32 nb_children = fixture->GetShape()->GetChildCount();
+      if (nb_children == 1) {
+	candidates->push_back({fixture, 0, fixture->GetAABB(0)});
+	return true;
+      }
+      // chains: the fixture is reported once per child proxy, add all its children the first time
+      for (auto& c : *candidates)
+	if (c.fixture == fixture)
+	  return true;
+      for (int32 child = 0; child < nb_children; child++)
+	candidates->push_back({fixture, child, fixture->GetAABB(child)});
+      return true;
+    }
+  }
+}
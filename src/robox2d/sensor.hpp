@@ -0,0 +1,185 @@
+#ifndef ROBOX2D_SENSOR_HPP
+#define ROBOX2D_SENSOR_HPP
+
+#include <memory>
+#include <vector>
+
+#include <box2d/box2d.h>
+
+#include "clone_map.hpp"
+#include "rasterizer.hpp"
+
+namespace robox2d {
+  namespace sensor {
+
+    /**
+     * @brief Sensor is an abstract class for sensors (rangefinders, lidars, ...)
+     *
+     * A sensor writes size() values in the observation buffer of its robot (see Robot::observations), at the rate
+     * set by Simu::set_sensor_period.
+     */
+    class Sensor {
+    public:
+      virtual ~Sensor() {}
+
+      virtual size_t size() const = 0;
+
+      /* Write the measure (size() values) in obs */
+      virtual void update(double* obs) = 0;
+
+      /* Copy of the sensor attached to the bodies cloned in map (nullptr if not supported) */
+      virtual std::shared_ptr<Sensor> clone(CloneMap& map) const {return nullptr;}
+    };
+
+    /**
+     * @brief RaySensor casts rays from a point of a body and measures the distance to the closest fixture.
+     *
+     * The measure is max_range when nothing is hit. The fixtures of the body itself and the sensor fixtures are
+     * ignored, as well as the fixtures whose category bits are not in the mask. The rays of all the ray sensors of
+     * a robot are cast together (see RayBatch).
+     */
+    class RaySensor : public Sensor {
+    public:
+      /* angles of the rays in the body frame */
+      RaySensor(b2Body* body, const b2Vec2& anchor, const std::vector<float>& angles, float max_range);
+
+      size_t size() const {return _angles.size();}
+
+      /* Cast the rays of this sensor alone (one batch) */
+      void update(double* obs);
+
+      std::shared_ptr<Sensor> clone(CloneMap& map) const;
+
+      void set_mask_bits(uint16 mask_bits) {_mask_bits = mask_bits;}
+      uint16 mask_bits() const {return _mask_bits;}
+
+      b2Body* body() const {return _body;}
+      const b2Vec2& anchor() const {return _anchor;}
+      const std::vector<float>& angles() const {return _angles;}
+      /* Unit vectors of the rays in the body frame */
+      const std::vector<b2Vec2>& directions() const {return _directions;}
+      float max_range() const {return _max_range;}
+
+    protected:
+      b2Body* _body;
+      b2Vec2 _anchor;
+      std::vector<float> _angles;
+      std::vector<b2Vec2> _directions;
+      float _max_range;
+      uint16 _mask_bits = 0xFFFF;
+    };
+
+    /**
+     * @brief Rangefinder measures the distance to the closest fixture in one direction.
+     */
+    class Rangefinder : public RaySensor {
+    public:
+      Rangefinder(b2Body* body, const b2Vec2& anchor, float angle, float max_range) :
+	RaySensor(body, anchor, {angle}, max_range) {}
+    };
+
+    /**
+     * @brief Lidar measures distances along nb_rays directions evenly spread over fov (radians) around angle.
+     *
+     * With a fov of 2*pi, the rays cover the full circle without duplicating the first one.
+     */
+    class Lidar : public RaySensor {
+    public:
+      Lidar(b2Body* body, const b2Vec2& anchor, size_t nb_rays, float fov, float max_range, float angle = 0.0f);
+
+    protected:
+      static std::vector<float> _spread(size_t nb_rays, float fov, float angle);
+    };
+
+    /**
+     * @brief GridSensor draws the world around a body into a small grid on the CPU (see Rasterizer).
+     *
+     * The grid is centered on the origin of the body; when egocentric, it turns with the body (the x axis of the
+     * body points to the right of the grid). The fixtures of the body itself are not drawn. The observation is the
+     * grid, row by row (row 0 at the top), channels values per cell.
+     */
+    class GridSensor : public Sensor {
+    public:
+      GridSensor(b2Body* body, size_t width, size_t height, float resolution, size_t channels, bool egocentric = true);
+
+      size_t size() const {return _rasterizer.data().size();}
+      void update(double* obs);
+
+      std::shared_ptr<Sensor> clone(CloneMap& map) const;
+
+      b2Body* body() const {return _body;}
+      bool egocentric() const {return _egocentric;}
+      /* Grid of the last update (float) */
+      const Rasterizer& rasterizer() const {return _rasterizer;}
+
+    protected:
+      b2Body* _body;
+      bool _egocentric;
+      Rasterizer _rasterizer;
+    };
+
+    /**
+     * @brief OccupancyGrid: 1 in the cells covered by a fixture, 0 elsewhere.
+     */
+    class OccupancyGrid : public GridSensor {
+    public:
+      OccupancyGrid(b2Body* body, size_t width, size_t height, float resolution, bool egocentric = true) :
+	GridSensor(body, width, height, resolution, 1, egocentric) {}
+    };
+
+    /**
+     * @brief TopDownCamera: RGB image (values in [0, 1]) with the colors of the renderer on a black background.
+     */
+    class TopDownCamera : public GridSensor {
+    public:
+      TopDownCamera(b2Body* body, size_t width, size_t height, float resolution, bool egocentric = true) :
+	GridSensor(body, width, height, resolution, 3, egocentric) {}
+    };
+
+    /**
+     * @brief Casts the rays of several RaySensors with a single query of the broadphase.
+     *
+     * cast() queries the dynamic tree once with the AABB of all the rays, then tests each ray against the
+     * candidate fixtures only. Each ray keeps the fraction of its closest hit so far as its maximum fraction, so
+     * the farther fixtures are rejected by an AABB test without any shape ray cast (early-out).
+     */
+    class RayBatch {
+    public:
+      void clear() {_sensors.clear(); _nb_rays = 0;}
+      /* The measures of sensor will be written in obs */
+      void add(RaySensor* sensor, double* obs);
+
+      void cast();
+
+      size_t nb_rays() const {return _nb_rays;}
+      /* Candidate fixtures of the last cast */
+      size_t nb_candidates() const {return _candidates.size();}
+
+    protected:
+      struct Entry {
+	RaySensor* sensor;
+	double* obs;
+      };
+
+      struct Candidate {
+	b2Fixture* fixture;
+	int32 child;
+	b2AABB aabb;
+      };
+
+      struct QueryCallback : public b2QueryCallback {
+	bool ReportFixture(b2Fixture* fixture) override;
+
+	std::vector<Candidate>* candidates = nullptr;
+      };
+
+      std::vector<Entry> _sensors;
+      size_t _nb_rays = 0;
+      std::vector<b2Vec2> _p1, _p2; // world coordinates of the rays
+      std::vector<Candidate> _candidates;
+      QueryCallback _query;
+    };
+  }
+}
+
+#endif
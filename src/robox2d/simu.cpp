@@ -1,75 +1,379 @@
 #include "simu.hpp"
 #include <iostream>
+#include <cmath>
+#include <limits>
+#include <cassert>
 #include <boost/math/common_factor.hpp>
+
+#ifdef ROBOX2D_PROFILING
+#define ROBOX2D_PROFILE_SCOPE(name, phase) Profiler::Scope name(_profiler, phase)
+#else
+#define ROBOX2D_PROFILE_SCOPE(name, phase)
+#endif
 namespace robox2d {
   
   Simu::Simu(size_t physic_freq, size_t control_freq, size_t graphic_freq) :
     _world(new b2World(b2Vec2(0.0f, 0.0f))),
+    _old_index(0),
+    _tick(0),
     _time(0),
     _sync(false),
-    _graphics(nullptr),
-    _old_index(0)
+    _graphics(nullptr)
   {
-  
-    _time_step = 1.0f/double( boost::math::lcm( boost::math::lcm(physic_freq, control_freq) , graphic_freq ));
-    _physic_period = 1.0f/(double)physic_freq;
-    _control_period = 1.0f/(double)control_freq;
-    _graphic_period = 1.0f/(double)graphic_freq;
+    _tick_freq = boost::math::lcm( boost::math::lcm(physic_freq, control_freq) , graphic_freq );
+    _physic_stride = _tick_freq / physic_freq;
+    _control_stride = _tick_freq / control_freq;
+    _graphic_stride = _tick_freq / graphic_freq;
+
+    _time_step = 1.0/double(_tick_freq);
+    _physic_period = 1.0/(double)physic_freq;
+    _control_period = 1.0/(double)control_freq;
+    _graphic_period = 1.0/(double)graphic_freq;
+    _state_cache.set_world(_world.get());
+    _world->SetDestructionListener(&_destruction_listeners);
   }
   
   Simu::~Simu()
   {
-    _robots.clear();
+    // the graphics (usually only owned by the simu) unregister from the destruction listeners of the simu
+    _graphics.reset();
+    // the world can outlive the simu (it is shared with the robots)
+    _world->SetDestructionListener(nullptr);
+    // the robots can outlive the simu too: they must not keep a pointer to its state cache
+    clear_robots();
     //_descriptors.clear();
     //_cameras.clear();
   }
-  
-  void Simu::run(double max_duration)
+
+  std::shared_ptr<Simu> Simu::clone() const
   {
-    double old_time = _time;
+    auto simu = std::make_shared<Simu>(_tick_freq / _physic_stride, _tick_freq / _control_stride, _tick_freq / _graphic_stride);
 
-    while ((_time - old_time - max_duration) < -_time_step/2.0 && (!_graphics || !_graphics->done())) {
-      _time+=_time_step;
+    b2World& world = *simu->_world;
+    world.SetGravity(_world->GetGravity());
+    world.SetAllowSleeping(_world->GetAllowSleeping());
+    world.SetWarmStarting(_world->GetWarmStarting());
+    world.SetContinuousPhysics(_world->GetContinuousPhysics());
+    world.SetSubStepping(_world->GetSubStepping());
+    world.SetAutoClearForces(_world->GetAutoClearForces());
+
+    CloneMap map(simu->_world);
+    map.clone_world(*_world);
+    for (auto& robot : _robots)
+      simu->add_robot(robot->clone(map));
+
+    simu->_old_index = _old_index;
+    simu->_tick = _tick;
+    simu->_time = _time;
+    simu->_sync = _sync;
+    simu->_sensor_period = _sensor_period;
+    simu->_hash_period = _hash_period;
+    simu->_pacer.set_real_time_factor(_pacer.real_time_factor());
+    simu->_pacer.set_max_lag(_pacer.max_lag());
+    simu->velocityIterations = velocityIterations;
+    simu->positionIterations = positionIterations;
+    return simu;
+  }
+
+  /**
+   * @brief Run the simulation for max_duration seconds (or until the graphics are closed or a termination triggers).
+   *
+   * Time is counted in integer ticks, so there is no drift over long runs. Instead of visiting every tick,
+   * the loop jumps directly to the next tick where the control, the physics or the graphics fire.
+   * When several of them fire on the same tick, they are executed in this order: control, physics, graphics.
+   *
+   * @param  max_duration duration (in seconds) of the simulation.
+   * @return why and when the run stopped.
+   */
+  RunResult Simu::run(double max_duration)
+  {
+    const size_t end_tick = _tick + static_cast<size_t>(std::llround(max_duration * _tick_freq));
+    const size_t never = std::numeric_limits<size_t>::max();
+
+    size_t next_control = _next_tick(_control_stride);
+    size_t next_physic = _next_tick(_physic_stride);
+    size_t next_graphic = _graphics ? _next_tick(_graphic_stride) : never;
+    RunResult result{RunResult::Duration, 0.0, 0};
+    invalidate_state(); // the world may have been changed since the last run
+    if (_sync)
+      _pacer.start(_time);
+#ifdef ROBOX2D_PROFILING
+    const size_t start_tick = _tick;
+    if (_profiler.enabled())
+      _profiler.begin_run();
+#endif
+
+    while (true) {
+      if (_graphics && _graphics->done()) {
+	result.reason = RunResult::GraphicsClosed;
+	break;
+      }
+      size_t next = std::min(next_control, std::min(next_physic, next_graphic));
+      if (next > end_tick)
+	break;
+
+      _tick = next;
+      _time = _tick * _time_step;
 
       // control step
-      if(std::abs(std::remainder(_time,_control_period)) < 1e-4)
+      if (_tick == next_control)
 	{
+	  if (!_batch_pending) {
+	    if (_sensor_period > 0 && (_tick / _control_stride) % _sensor_period == 0) {
+	      ROBOX2D_PROFILE_SCOPE(sensors_scope, SimuStats::Sensors);
+	      for (auto& robot : _robots)
+		robot->sensor_update();
+	    }
+	    // the owner of an external batch updates it while the simu is stopped
+	    if (_batch_controller && _external_batch) {
+	      _batch_pending = true;
+	      result.reason = RunResult::BatchPending;
+	      break;
+	    }
+	  }
+	  _batch_pending = false;
+	  ROBOX2D_PROFILE_SCOPE(control_scope, SimuStats::Control);
+	  if (_batch_controller && !_external_batch)
+	    _batch_controller->update();
 	  for (auto& robot : _robots)
 	    robot->control_update(_time);
+	  if (_action_logger)
+	    _action_logger->control_update(*this);
+	  next_control += _control_stride;
 	}
       
       // physic step
-      if(std::abs(std::remainder(_time,_physic_period)) < 1e-4)
+      if (_tick == next_physic)
 	{
-	  for (auto& robot : _robots)
-	    robot->physic_update();	
-	  _world->Step(_time_step, velocityIterations, positionIterations);
+	  {
+	    // the step latency (SimuStats::step) covers the actuators, the world step and the descriptors
+	    ROBOX2D_PROFILE_SCOPE(step_scope, SimuStats::PhysicStep);
+	    {
+	      ROBOX2D_PROFILE_SCOPE(actuators_scope, SimuStats::Actuators);
+	      for (auto& robot : _robots)
+		robot->physic_update();
+	    }
+	    {
+	      ROBOX2D_PROFILE_SCOPE(world_scope, SimuStats::WorldStep);
+	      _world->Step(_physic_period, velocityIterations, positionIterations);
+	    }
+	    _state_cache.invalidate();
+	    for (auto& robot : _robots)
+	      robot->invalidate_state(1.0 / _physic_period);
 
-	  // Update descriptors
-	  for (auto& desc : _descriptors) {
-	    if (_old_index % desc->desc_dump() == 0) {
-	      desc->operator()();
+	    // Update descriptors
+	    {
+	      ROBOX2D_PROFILE_SCOPE(descriptors_scope, SimuStats::Descriptors);
+	      for (auto& desc : _descriptors) {
+		if (_old_index % desc->desc_dump() == 0) {
+		  desc->operator()();
+		}
+	      }
 	    }
 	  }
+
+	  // State hash (see enable_state_hash)
+	  if (_hash_period > 0 && _old_index % _hash_period == 0)
+	    _state_hashes.push_back(_tick, world_hash(*_world));
+
+	  // Check the termination conditions (after the descriptors, so they see the last step)
+	  bool terminated = false;
+	  if (_action_logger && !_action_logger->physic_update(*this)) {
+	    result.reason = RunResult::Diverged;
+	    terminated = true;
+	  }
+	  for (size_t i = 0; i < _terminations.size() && !terminated; i++) {
+	    if (_old_index % _terminations[i]->check_period() == 0 && _terminations[i]->operator()()) {
+	      result.reason = RunResult::Termination;
+	      result.termination = i;
+	      terminated = true;
+	      break;
+	    }
+	  }
+	  _old_index++;
+	  next_physic += _physic_stride;
+	  if (terminated)
+	    break;
 	}
       
       // graphic step
-      if(_graphics && std::abs(std::remainder(_time,_graphic_period)) < 1e-4)
+      if (_tick == next_graphic)
 	{
-	  _graphics->refresh();
-	  if (_sync) {
-          usleep(_graphic_period * 1e6);
-      }
+	  {
+	    ROBOX2D_PROFILE_SCOPE(graphics_scope, SimuStats::Graphics);
+	    _graphics->refresh();
+	  }
+	  next_graphic += _graphic_stride;
 	}
 
-      _old_index++;
-      
+      // real-time pacing: sleep only for what remains of the budget of this tick
+      if (_sync)
+	_pacer.wait(_time);
+    }
+
+    if (result.reason == RunResult::Duration) {
+      _tick = end_tick;
+      _time = _tick * _time_step;
+    }
+    if (_sync) {
+      if (result.reason == RunResult::Duration)
+	_pacer.wait(_time); // the end of the duration is part of the budget
+      else
+	_pacer.stop(_time);
     }
+#ifdef ROBOX2D_PROFILING
+    if (_profiler.enabled())
+      _profiler.end_run((_tick - start_tick) * _time_step);
+#endif
+    result.time = _time;
+    return result;
+  }
+
+  size_t Simu::_next_tick(size_t stride) const
+  {
+    // a tick stopped before its control update (see set_batch_controller) is resumed first
+    size_t first = _batch_pending ? _tick : _tick + 1;
+    return (first + stride - 1) / stride * stride;
   }
 
   
   
+  namespace {
+    float joint_motor_speed(b2Joint* joint)
+    {
+      switch (joint->GetType()) {
+      case e_revoluteJoint:
+	return static_cast<b2RevoluteJoint*>(joint)->GetMotorSpeed();
+      case e_prismaticJoint:
+	return static_cast<b2PrismaticJoint*>(joint)->GetMotorSpeed();
+      case e_wheelJoint:
+	return static_cast<b2WheelJoint*>(joint)->GetMotorSpeed();
+      default:
+	return 0.0f;
+      }
+    }
+
+    void set_joint_motor_speed(b2Joint* joint, float speed)
+    {
+      switch (joint->GetType()) {
+      case e_revoluteJoint:
+	static_cast<b2RevoluteJoint*>(joint)->SetMotorSpeed(speed);
+	break;
+      case e_prismaticJoint:
+	static_cast<b2PrismaticJoint*>(joint)->SetMotorSpeed(speed);
+	break;
+      case e_wheelJoint:
+	static_cast<b2WheelJoint*>(joint)->SetMotorSpeed(speed);
+	break;
+      default:
+	break;
+      }
+    }
+  }
+
+  /**
+   * @brief Capture the state of the simulation: bodies (transforms, velocities, sleep state), joint motors,
+   * actuators and controllers internal state and time.
+   * 
+   * @return Snapshot 
+   */
+  Snapshot Simu::snapshot() const
+  {
+    Snapshot snap;
+    snapshot(snap);
+    return snap;
+  }
+
+  /**
+   * @brief Same as snapshot(), but reuses the memory of an existing snapshot (no allocation once it has the right size).
+   */
+  void Simu::snapshot(Snapshot& snap) const
+  {
+    snap.time = _time;
+    snap.tick = _tick;
+    snap.physic_index = _old_index;
+
+    // read from the bodies: the world state may be stale if the world was changed since the last invalidate_state()
+    snap.bodies.resize(_world->GetBodyCount());
+    size_t i = 0;
+    for (const b2Body* body = _world->GetBodyList(); body; body = body->GetNext(), i++) {
+      auto& b = snap.bodies[i];
+      const b2Transform& xf = body->GetTransform();
+      const b2Vec2& v = body->GetLinearVelocity();
+      b.x = xf.p.x;
+      b.y = xf.p.y;
+      b.angle = body->GetAngle();
+      b.vx = v.x;
+      b.vy = v.y;
+      b.w = body->GetAngularVelocity();
+      b.awake = body->IsAwake();
+    }
+
+    snap.joints.resize(_world->GetJointCount());
+    i = 0;
+    for (b2Joint* joint = _world->GetJointList(); joint; joint = joint->GetNext(), i++)
+      snap.joints[i].motor_speed = joint_motor_speed(joint);
+
+    size_t size = 0;
+    for (auto& robot : _robots)
+      size += robot->state_size();
+    snap.robots.resize(size);
+    double* state = snap.robots.data();
+    for (auto& robot : _robots) {
+      robot->save_state(state);
+      state += robot->state_size();
+    }
+  }
+
+  /**
+   * @brief Overwrite the state of the simulation with a snapshot taken in this simu. Nothing is allocated or rebuilt.
+   */
+  void Simu::restore(const Snapshot& snap)
+  {
+    assert(snap.bodies.size() == (size_t)_world->GetBodyCount() && "Snapshot does not match the world (bodies)");
+    assert(snap.joints.size() == (size_t)_world->GetJointCount() && "Snapshot does not match the world (joints)");
+
+    _time = snap.time;
+    _tick = snap.tick;
+    _old_index = snap.physic_index;
+
+    size_t i = 0;
+    for (b2Body* body = _world->GetBodyList(); body; body = body->GetNext(), i++) {
+      const auto& b = snap.bodies[i];
+      body->SetTransform({b.x, b.y}, b.angle);
+      body->SetLinearVelocity({b.vx, b.vy});
+      body->SetAngularVelocity(b.w);
+      body->SetAwake(b.awake);
+    }
+
+    i = 0;
+    for (b2Joint* joint = _world->GetJointList(); joint; joint = joint->GetNext(), i++)
+      set_joint_motor_speed(joint, snap.joints[i].motor_speed);
+
+    const double* state = snap.robots.data();
+    for (auto& robot : _robots) {
+      assert(state + robot->state_size() <= snap.robots.data() + snap.robots.size() && "Snapshot does not match the robots");
+      robot->load_state(state);
+      state += robot->state_size();
+    }
+    invalidate_state();
+  }
+
   std::shared_ptr<gui::Base> Simu::graphics() const { return _graphics; }
+
+  void Simu::invalidate_state()
+  {
+    _state_cache.invalidate();
+    for (auto& robot : _robots)
+      robot->invalidate_state();
+  }
+
+  void Simu::set_action_logger(const std::shared_ptr<ActionLogger>& logger)
+  {
+    _action_logger = logger;
+    if (_action_logger)
+      _action_logger->attach(*this);
+  }
   
   void Simu::set_graphics(const std::shared_ptr<gui::Base>& graphics) { _graphics = graphics; }
   
@@ -94,6 +398,7 @@ namespace robox2d {
   {
     
     _robots.push_back(robot);
+    robot->set_state_cache(&_state_cache);
     //_world->addSkeleton(robot->skeleton());
     
   }
@@ -103,6 +408,7 @@ namespace robox2d {
     auto it = std::find(_robots.begin(), _robots.end(), robot);
     if (it != _robots.end()) {
       //   _world->removeSkeleton(robot->skeleton());
+      (*it)->set_state_cache(nullptr);
       _robots.erase(it);
     }
   }
@@ -111,6 +417,7 @@ namespace robox2d {
   {
     //ROBOT_DART_ASSERT(index < _robots.size(), "Robot index out of bounds", );
     //_world->removeSkeleton(_robots[index]->skeleton());
+    _robots[index]->set_state_cache(nullptr);
     _robots.erase(_robots.begin() + index);
   }
   
@@ -119,6 +426,8 @@ namespace robox2d {
     //for (auto& robot : _robots) {
     //     _world->removeSkeleton(robot->skeleton());
     // }
+    for (auto& robot : _robots)
+      robot->set_state_cache(nullptr);
     _robots.clear();
   }
 
@@ -154,6 +463,38 @@ namespace robox2d {
       _descriptors.clear();
     }
 
+    // Methods for manipulating the termination conditions
+
+    void Simu::add_termination(const std::shared_ptr <termination::BaseTermination> &term) {
+      _terminations.push_back(term);
+      term->set_simu(this);
+    }
+
+    std::vector <std::shared_ptr<termination::BaseTermination>> Simu::terminations() const {
+      return _terminations;
+    }
+
+    std::shared_ptr <termination::BaseTermination> Simu::termination(size_t index) const {
+      assert((index < _terminations.size()) && "Termination index out of bounds");
+      return _terminations[index];
+    }
+
+    void Simu::remove_termination(const std::shared_ptr <termination::BaseTermination> &term) {
+      auto it = std::find(_terminations.begin(), _terminations.end(), term);
+      if (it != _terminations.end()) {
+        _terminations.erase(it);
+      }
+    }
+
+    void Simu::remove_termination(size_t index) {
+      assert((index < _terminations.size()) && "Termination index out of bounds");
+      _terminations.erase(_terminations.begin() + index);
+    }
+
+    void Simu::clear_terminations() {
+      _terminations.clear();
+    }
+
 
   /**
    * @brief Creates a floor (static body) of width 50, height 0.5 and placed at y = -10.5
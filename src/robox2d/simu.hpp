@@ -11,12 +11,34 @@
 
 #include "common.hpp"
 #include "robot.hpp"
+#include "snapshot.hpp"
+#include "profiler.hpp"
+#include "pacer.hpp"
+#include "action_log.hpp"
+#include "hash.hpp"
+#include "world_state.hpp"
+#include "destruction_listener.hpp"
+#include "control/batch_controller.hpp"
 #include "gui/base.hpp"
 
 #include "robox2d/descriptor/base_descriptor.hpp"
+#include "robox2d/termination/base_termination.hpp"
 
 
 namespace robox2d {
+
+  /**
+   * @brief Why and when Simu::run stopped.
+   */
+  struct RunResult {
+    enum Reason { Duration, GraphicsClosed, Termination, Diverged, BatchPending };
+
+    Reason reason;
+    double time; // simu time when the run stopped
+    size_t termination; // index of the termination that stopped the run (only valid when reason == Termination)
+    // Diverged: the world differs from the action log being replayed (see ActionLogger)
+    // BatchPending: stopped at a control tick for an external batch controller (see Simu::set_batch_controller)
+  };
   
   class Simu {
   public:
@@ -26,13 +48,42 @@ namespace robox2d {
      * @brief Construct a new Simu object.
      * 
      * Create a new world, world has zero gravity.
+     * The simulation advances in integer ticks of 1/lcm(physic_freq, control_freq, graphic_freq) seconds,
+     * and each subsystem fires every `lcm/freq` ticks.
      */
     Simu(size_t physic_freq=100, size_t control_freq=50, size_t graphic_freq=50);
     
     ~Simu();
+
+    /**
+     * @brief Deep copy of the simulation: world (bodies, fixtures, joints), robots and time.
+     *
+     * Graphics, descriptors, terminations and the action logger are not copied. The copy does not share any Box2D object with this simu,
+     * so both can be stepped from different threads.
+     */
+    std::shared_ptr<Simu> clone() const;
     
-    void run(double max_duration = 5.0);
+    RunResult run(double max_duration = 5.0);
+
+    double time() const { return _time; }
+    size_t tick() const { return _tick; }
+    size_t tick_freq() const { return _tick_freq; }
+    double physic_period() const { return _physic_period; }
+    double control_period() const { return _control_period; }
+    double graphic_period() const { return _graphic_period; }
+
+    // Methods for profiling (only active when compiled with ROBOX2D_PROFILING)
+
+    void enable_profiling(bool enable = true, bool trace = false) { _profiler.set_enabled(enable); _profiler.set_tracing(trace); }
+    const SimuStats& stats() const { return _profiler.stats(); }
+    void reset_stats() { _profiler.reset(); }
+    bool dump_trace(const std::string& filename) const { return _profiler.dump_trace(filename); }
 
+    // Methods for saving and restoring the state of the simulation
+
+    Snapshot snapshot() const;
+    void snapshot(Snapshot& snapshot) const;
+    void restore(const Snapshot& snapshot);
     
     
     std::shared_ptr<gui::Base> graphics() const;
@@ -40,6 +91,21 @@ namespace robox2d {
     
     std::shared_ptr<b2World> world();
 
+    /**
+     * @brief Transforms and velocities of all the bodies, gathered at most once per physic step (on demand).
+     *
+     * Controllers, descriptors and renderers should read the bodies from here rather than from the world.
+     * run() starts with a fresh state; call invalidate_state() after changing the world during a run (from a
+     * controller or a descriptor) or between two reads.
+     */
+    const WorldState& world_state() const { return _state_cache.get(); }
+    const WorldStateCache& world_state_cache() const { return _state_cache; }
+    /* Mark the world state and the state of the robots as outdated */
+    void invalidate_state();
+
+    /* Destruction listener of the world: register listeners here rather than with b2World::SetDestructionListener */
+    DestructionListeners& destruction_listeners() { return _destruction_listeners; }
+
       // Methods for manipulating robox2d descriptors
 
       template<typename Descriptor>
@@ -58,6 +124,61 @@ namespace robox2d {
       void remove_descriptor(size_t index);
 
       void clear_descriptors();
+
+      // Methods for manipulating the termination conditions of run
+
+      template<typename Termination>
+      void add_termination(size_t check_period = 1) {
+        add_termination(std::make_shared<Termination>(Termination{check_period}));
+      }
+
+      void add_termination(const std::shared_ptr <termination::BaseTermination> &term);
+
+      std::vector <std::shared_ptr<termination::BaseTermination>> terminations() const;
+
+      std::shared_ptr <termination::BaseTermination> termination(size_t index) const;
+
+      void remove_termination(const std::shared_ptr <termination::BaseTermination> &term);
+
+      void remove_termination(size_t index);
+
+      void clear_terminations();
+
+    /* Update the sensors of the robots every period control ticks, before the control update (0 to disable) */
+    void set_sensor_period(size_t period) { _sensor_period = period; }
+    size_t sensor_period() const { return _sensor_period; }
+
+    /**
+     * @brief Hash the world (see world_hash) every period physic steps and append it to state_hashes().
+     *
+     * Compare the streams of two runs with first_divergence. Disabled by default; the cost is a few
+     * multiplications per body.
+     */
+    void enable_state_hash(bool enable = true, size_t period = 1) { _hash_period = enable ? period : 0; }
+    bool state_hash_enabled() const { return _hash_period > 0; }
+    const HashStream& state_hashes() const { return _state_hashes; }
+    void clear_state_hashes() { _state_hashes.clear(); }
+
+    /**
+     * @brief Controller updated at each control tick, after the sensors and before the controllers of the robots.
+     *
+     * With external, the batch is shared with other simus (see SimuPool::set_batch_controller): run() stops at
+     * each control tick, after the sensors, with RunResult::BatchPending. The owner of the batch calls update()
+     * once all the simus are stopped, and the next run() resumes the tick with the control update.
+     * Not copied by clone().
+     */
+    void set_batch_controller(const std::shared_ptr<control::BatchController>& controller, bool external = false)
+    {
+      _batch_controller = controller;
+      _external_batch = external;
+    }
+    const std::shared_ptr<control::BatchController>& batch_controller() const { return _batch_controller; }
+    /* True when run() stopped before the control update of the current tick */
+    bool batch_pending() const { return _batch_pending; }
+
+    /* Record or replay the commands of the robots (see ActionLogger); nullptr to stop */
+    void set_action_logger(const std::shared_ptr<ActionLogger>& logger);
+    const std::shared_ptr<ActionLogger>& action_logger() const { return _action_logger; }
     
     /*    void add_camera(const std::shared_ptr<gui::Base>& cam);
         std::vector<std::shared_ptr<gui::Base>> cameras() const;
@@ -82,12 +203,28 @@ namespace robox2d {
     void add_floor();//double floor_width = 10.0, double floor_height = 0.1, const Eigen::Vector6d& pose = Eigen::Vector6d::Zero(), const std::string& floor_name = "floor");
     //  void add_checkerboard_floor(double floor_width = 10.0, double floor_height = 0.1, double size = 1., const Eigen::Vector6d& pose = Eigen::Vector6d::Zero(), const std::string& floor_name = "checkerboard_floor");
 
+    /* With sync, run() is paced to the real-time factor against the wall clock (see Pacer) */
     void set_sync(bool sync) { _sync = sync; };
     bool get_sync() { return _sync; };
 
+    /* Target real-time factor when synced (1 by default, 0 for as fast as possible) */
+    void set_real_time_factor(double rtf) { _pacer.set_real_time_factor(rtf); }
+    double real_time_factor() const { return _pacer.real_time_factor(); }
+    /* Achieved vs target real-time factor of the synced runs */
+    const PacingStats& pacing_stats() const { return _pacer.stats(); }
+    Pacer& pacer() { return _pacer; }
+
   protected:
+    size_t _next_tick(size_t stride) const;
+
     std::shared_ptr<b2World> _world;
-    size_t _old_index;
+    size_t _old_index; // number of physic steps done so far (used for descriptors)
+
+    size_t _tick; // number of ticks since the creation of the simu
+    size_t _tick_freq; // lcm of the physic, control and graphic frequencies
+    size_t _physic_stride; // number of ticks between two physic steps
+    size_t _control_stride;
+    size_t _graphic_stride;
 
     double _physic_period;
     double _control_period;
@@ -99,10 +236,24 @@ namespace robox2d {
     int32 velocityIterations = 6;
     int32 positionIterations = 2;
      
+    // before the graphics and the robots, which may use them until they are destroyed
+    WorldStateCache _state_cache;
+    DestructionListeners _destruction_listeners;
+
     std::vector<std::shared_ptr<descriptor::BaseDescriptor>> _descriptors;
+    std::vector<std::shared_ptr<termination::BaseTermination>> _terminations;
     //std::vector<std::shared_ptr<gui::Base>> _cameras; // designed to include mainly graphcis::CameraOSR
     std::vector<robot_t> _robots;
     std::shared_ptr<gui::Base> _graphics;
+    std::shared_ptr<ActionLogger> _action_logger;
+    std::shared_ptr<control::BatchController> _batch_controller;
+    bool _external_batch = false;
+    bool _batch_pending = false; // the control update of the current tick is still to be done
+    size_t _sensor_period = 1; // in control ticks
+    size_t _hash_period = 0; // 0: no state hash
+    HashStream _state_hashes;
+    Profiler _profiler;
+    Pacer _pacer;
   };
 
 
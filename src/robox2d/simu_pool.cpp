@@ -0,0 +1,145 @@
+#include "simu_pool.hpp"
+
+#include <algorithm>
+
+namespace robox2d {
+
+  SimuPool::SimuPool(size_t nb_envs, const factory_t& factory, const evaluator_t& evaluator, size_t result_size, double episode_duration, size_t nb_threads) :
+    _factory(factory),
+    _evaluator(evaluator),
+    _episode_duration(episode_duration),
+    _envs(nb_envs),
+    _results(result_size, 0),
+    _nb_episodes(0),
+    _episode_counter(0),
+    _nb_finished(0),
+    _pool(nb_threads)
+  {
+  }
+
+  void SimuPool::reset(size_t nb_episodes)
+  {
+    _nb_episodes = nb_episodes;
+    _episode_counter = 0;
+    _nb_finished = 0;
+    _results.setZero(_results.rows(), nb_episodes);
+
+    _pool.parallel_for(_envs.size(), [this](size_t i) {
+      _envs[i].simu.reset();
+      _next_episode(_envs[i]);
+    });
+  }
+
+  size_t SimuPool::step(double duration)
+  {
+    if (_batch_controller)
+      return _step_batch(duration);
+
+    std::atomic<size_t> nb_running(0);
+    _pool.parallel_for(_envs.size(), [&](size_t i) {
+      Env& env = _envs[i];
+      if (!env.simu)
+	return;
+
+      // an episode is over at the end of its duration, or earlier if one of its terminations triggered
+      RunResult run = env.simu->run(std::min(duration, _remaining(env)));
+      if (run.reason != RunResult::Duration || _remaining(env) <= 0.0) {
+	_finish(env);
+	if (!_next_episode(env))
+	  return;
+      }
+      nb_running++;
+    });
+    return nb_running;
+  }
+
+  size_t SimuPool::_step_batch(double duration)
+  {
+    for (auto& env : _envs)
+      if (env.simu)
+	env.stop = env.simu->time() + duration;
+
+    // each round runs the environments to their next control tick, then the batch computes all the commands
+    std::atomic<size_t> nb_pending(0);
+    do {
+      nb_pending = 0;
+      _pool.parallel_for(_envs.size(), [&](size_t i) {
+	Env& env = _envs[i];
+	if (!env.simu || (!env.simu->batch_pending() && env.simu->time() >= env.stop))
+	  return;
+
+	RunResult run = env.simu->run(std::max(0.0, std::min(env.stop - env.simu->time(), _remaining(env))));
+	if (run.reason == RunResult::BatchPending) {
+	  nb_pending++;
+	  return;
+	}
+	// the new episode starts at the next step
+	if (run.reason != RunResult::Duration || _remaining(env) <= 0.0) {
+	  _finish(env);
+	  _next_episode(env);
+	}
+	env.stop = 0.0;
+      });
+      if (nb_pending > 0)
+	_batch_controller->update();
+    } while (nb_pending > 0);
+
+    size_t nb_running = 0;
+    for (auto& env : _envs)
+      if (env.simu)
+	nb_running++;
+    return nb_running;
+  }
+
+  void SimuPool::run()
+  {
+    // the batch needs all the environments at the same control tick
+    if (_batch_controller) {
+      while (!done())
+	_step_batch(_episode_duration);
+      return;
+    }
+    for (size_t i = 0; i < _envs.size(); i++)
+      if (_envs[i].simu)
+	_pool.submit([this, i]() { _run_env(i); });
+    _pool.wait();
+  }
+
+  void SimuPool::_run_env(size_t index)
+  {
+    Env& env = _envs[index];
+    env.simu->run(_remaining(env)); // stops at the end of the episode or when a termination triggers
+    _finish(env);
+    // the next episode of this environment goes on the local queue: idle workers can steal it
+    if (_next_episode(env))
+      _pool.submit([this, index]() { _run_env(index); });
+  }
+
+  bool SimuPool::_next_episode(Env& env)
+  {
+    size_t episode = _episode_counter++;
+    if (episode >= _nb_episodes) {
+      env.simu.reset();
+      return false;
+    }
+    env.episode = episode;
+    env.simu = _factory(episode);
+    if (_batch_controller)
+      env.simu->set_batch_controller(_batch_controller, true);
+    env.start = env.simu->time();
+    return true;
+  }
+
+  double SimuPool::_remaining(const Env& env) const
+  {
+    // half a tick of tolerance: Simu::run rounds durations to the closest tick
+    double remaining = _episode_duration - (env.simu->time() - env.start);
+    return remaining > 0.5 / env.simu->tick_freq() ? remaining : 0.0;
+  }
+
+  void SimuPool::_finish(Env& env)
+  {
+    _evaluator(*env.simu, env.episode, _results.col(env.episode).data());
+    _nb_finished++;
+  }
+} // namespace robox2d
@@ -0,0 +1,118 @@
+#ifndef ROBOX2D_SIMU_POOL_HPP
+#define ROBOX2D_SIMU_POOL_HPP
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include "simu.hpp"
+#include "thread_pool.hpp"
+
+namespace robox2d {
+
+  /**
+   * @brief SimuPool evaluates many independent episodes on a fixed pool of worker threads.
+   *
+   * The pool owns nb_envs environments (each one is a Simu with its own b2World and robots). Each environment
+   * runs one episode at a time; when an episode is over (end of its duration, or a termination of its simu
+   * triggered, see Simu::add_termination), its result is written in the results matrix and the environment is
+   * reset with the next episode to evaluate. Environments can be stepped in lockstep (step()) or run
+   * asynchronously until all the episodes are done (run()).
+   *
+   * The factory and the evaluator are called from the worker threads: they must be thread-safe.
+   */
+  class SimuPool {
+  public:
+    using simu_t = std::shared_ptr<Simu>;
+    /* Build the simu of an episode */
+    using factory_t = std::function<simu_t(size_t episode)>;
+    /* Write the result of a finished episode in result (result_size values) */
+    using evaluator_t = std::function<void(Simu& simu, size_t episode, double* result)>;
+
+    /**
+     * @brief Construct a new SimuPool object
+     *
+     * @param  nb_envs number of environments stepped in parallel.
+     * @param  factory function building the simu of an episode.
+     * @param  evaluator function writing the result of a finished episode.
+     * @param  result_size number of values written by the evaluator.
+     * @param  episode_duration duration (in seconds) of an episode.
+     * @param  nb_threads number of workers (0 means one per core).
+     */
+    SimuPool(size_t nb_envs, const factory_t& factory, const evaluator_t& evaluator, size_t result_size, double episode_duration = 5.0, size_t nb_threads = 0);
+
+    /* Start a new batch of nb_episodes episodes (the results of the previous batch are discarded) */
+    void reset(size_t nb_episodes);
+
+    /**
+     * @brief Advance all the running environments by duration seconds, in lockstep.
+     *
+     * Finished episodes are evaluated and their environment is reset with the next episode.
+     *
+     * @return number of environments still running an episode.
+     */
+    size_t step(double duration);
+
+    /* Run all the remaining episodes asynchronously and wait for them (in lockstep with a batch controller) */
+    void run();
+
+    /**
+     * @brief Controller shared by the robots of all the environments (see control::BatchedMLP).
+     *
+     * The simu of each episode is stopped at each of its control ticks (see Simu::set_batch_controller): step()
+     * runs the environments in lockstep from one control tick to the next and updates the batch in between.
+     * The factory adds the robots of its simu to the batch. All the simus must have the same control frequency.
+     */
+    void set_batch_controller(const std::shared_ptr<control::BatchController>& controller) { _batch_controller = controller; }
+    const std::shared_ptr<control::BatchController>& batch_controller() const { return _batch_controller; }
+
+    bool done() const { return _nb_finished == _nb_episodes; }
+
+    size_t nb_envs() const { return _envs.size(); }
+    size_t nb_threads() const { return _pool.size(); }
+    size_t nb_episodes() const { return _nb_episodes; }
+    size_t nb_finished() const { return _nb_finished; }
+
+    double episode_duration() const { return _episode_duration; }
+    void set_episode_duration(double duration) { _episode_duration = duration; }
+
+    /* Current simu of environment env (nullptr when the environment is idle) */
+    simu_t simu(size_t env) const { return _envs[env].simu; }
+
+    /* One column per episode (contiguous) */
+    const Eigen::MatrixXd& results() const { return _results; }
+    const double* result(size_t episode) const { return _results.col(episode).data(); }
+
+  protected:
+    struct Env {
+      simu_t simu;
+      size_t episode = 0;
+      double start = 0; // simu time at the beginning of the episode
+      double stop = 0; // simu time at the end of the current step (lockstep with a batch controller)
+    };
+
+    bool _next_episode(Env& env);
+    double _remaining(const Env& env) const;
+    void _finish(Env& env);
+    void _run_env(size_t index);
+    size_t _step_batch(double duration);
+
+    factory_t _factory;
+    evaluator_t _evaluator;
+    double _episode_duration;
+    std::shared_ptr<control::BatchController> _batch_controller;
+
+    std::vector<Env> _envs;
+    Eigen::MatrixXd _results;
+    size_t _nb_episodes;
+    std::atomic<size_t> _episode_counter;
+    std::atomic<size_t> _nb_finished;
+
+    ThreadPool _pool;
+  };
+} // namespace robox2d
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef ROBOX2D_SNAPSHOT_HPP
+#define ROBOX2D_SNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace robox2d {
+
+  /**
+   * @brief Snapshot is the state of a Simu at a given time (see Simu::snapshot and Simu::restore).
+   *
+   * Bodies and joints are stored in the order of b2World::GetBodyList and b2World::GetJointList, so a snapshot
+   * can only be restored in the simu it was taken from (or in a simu with the same bodies and joints).
+   * Contact caches (warm starting) and sleep timers are not part of the snapshot.
+   */
+  struct Snapshot {
+    struct Body {
+      float x, y, angle; // position of the body origin
+      float vx, vy, w; // linear and angular velocities
+      uint8_t awake;
+    };
+
+    struct Joint {
+      float motor_speed; // only for revolute, prismatic and wheel joints
+    };
+
+    double time = 0;
+    size_t tick = 0;
+    size_t physic_index = 0;
+
+    std::vector<Body> bodies;
+    std::vector<Joint> joints;
+    std::vector<double> robots; // internal state of the actuators and controllers of each robot
+  };
+} // namespace robox2d
+
+#endif
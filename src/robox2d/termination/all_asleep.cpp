@@ -0,0 +1,14 @@
+#include "robox2d/termination/all_asleep.hpp"
+#include "robox2d/simu.hpp"
+
+namespace robox2d {
+    namespace termination {
+        bool AllAsleep::operator()()
+        {
+          for (b2Body* body = _simu->world()->GetBodyList(); body; body = body->GetNext())
+            if (body->GetType() != b2_staticBody && body->IsAwake())
+              return false;
+          return true;
+        }
+    } // namespace termination
+} // namespace robox2d
@@ -0,0 +1,23 @@
+#ifndef ROBOX2D_OFFICIAL_ALL_ASLEEP_HPP
+#define ROBOX2D_OFFICIAL_ALL_ASLEEP_HPP
+
+#include "robox2d/termination/base_termination.hpp"
+
+namespace robox2d {
+    namespace termination {
+
+        /**
+         * @brief Stop when all the dynamic bodies of the world are asleep (nothing will move anymore).
+         *
+         * The body list is walked until the first awake body, so the check is cheap while the world is active.
+         */
+        struct AllAsleep : public BaseTermination {
+        public:
+            AllAsleep(size_t check_period = 1) : BaseTermination(check_period) {}
+
+            bool operator()() override;
+        };
+    } // namespace termination
+} // namespace robox2d
+
+#endif //ROBOX2D_OFFICIAL_ALL_ASLEEP_HPP
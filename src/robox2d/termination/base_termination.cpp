@@ -0,0 +1,18 @@
+#include "robox2d/termination/base_termination.hpp"
+#include "robox2d/simu.hpp"
+
+namespace robox2d {
+    namespace termination {
+        BaseTermination::BaseTermination(size_t check_period) : _simu(nullptr), _check_period(check_period) {}
+
+        size_t BaseTermination::check_period() const
+        {
+          return _check_period;
+        }
+
+        void BaseTermination::set_check_period(size_t check_period)
+        {
+          _check_period = check_period;
+        }
+    } // namespace termination
+} // namespace robox2d
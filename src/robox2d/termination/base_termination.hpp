@@ -0,0 +1,41 @@
+#ifndef ROBOX2D_OFFICIAL_BASE_TERMINATION_HPP
+#define ROBOX2D_OFFICIAL_BASE_TERMINATION_HPP
+
+// for size_t
+#include <cstddef>
+
+namespace robox2d {
+    class Simu;
+
+    namespace termination {
+
+        /**
+         * @brief Predicate stopping Simu::run before the end of its duration.
+         *
+         * It is checked after the physic step, every check_period physic steps (like the descriptors).
+         */
+        struct BaseTermination {
+        public:
+            BaseTermination(size_t check_period = 1);
+
+            virtual ~BaseTermination() {}
+
+            /* Return true to stop the simulation */
+            virtual bool operator()() = 0;
+
+            size_t check_period() const;
+
+            void set_check_period(size_t check_period);
+
+            void set_simu(Simu *simu) { _simu = simu; }
+
+            const Simu *simu() const { return _simu; }
+
+        protected:
+            Simu *_simu;
+            size_t _check_period;
+        };
+    } // namespace termination
+} // namespace robox2d
+
+#endif //ROBOX2D_OFFICIAL_BASE_TERMINATION_HPP
@@ -0,0 +1,11 @@
+#include "robox2d/termination/predicate.hpp"
+#include "robox2d/simu.hpp"
+
+namespace robox2d {
+    namespace termination {
+        bool Predicate::operator()()
+        {
+          return _predicate(*_simu);
+        }
+    } // namespace termination
+} // namespace robox2d
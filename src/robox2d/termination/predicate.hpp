@@ -0,0 +1,28 @@
+#ifndef ROBOX2D_OFFICIAL_PREDICATE_HPP
+#define ROBOX2D_OFFICIAL_PREDICATE_HPP
+
+#include <functional>
+
+#include "robox2d/termination/base_termination.hpp"
+
+namespace robox2d {
+    namespace termination {
+
+        /**
+         * @brief Stop when a user function returns true (robot fallen, out of the arena, ...).
+         */
+        struct Predicate : public BaseTermination {
+        public:
+            using predicate_t = std::function<bool(Simu&)>;
+
+            Predicate(const predicate_t& predicate, size_t check_period = 1) : BaseTermination(check_period), _predicate(predicate) {}
+
+            bool operator()() override;
+
+        protected:
+            predicate_t _predicate;
+        };
+    } // namespace termination
+} // namespace robox2d
+
+#endif //ROBOX2D_OFFICIAL_PREDICATE_HPP
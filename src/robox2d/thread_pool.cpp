@@ -0,0 +1,117 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace robox2d {
+
+  namespace {
+    // worker identity of the current thread (used to push nested tasks on the local queue)
+    thread_local const ThreadPool* current_pool = nullptr;
+    thread_local size_t current_index = 0;
+  }
+
+  ThreadPool::ThreadPool(size_t nb_threads) :
+    _queued(0),
+    _pending(0),
+    _next_queue(0),
+    _stop(false)
+  {
+    if (nb_threads == 0)
+      nb_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < nb_threads; i++)
+      _queues.emplace_back(new Queue());
+    for (size_t i = 0; i < nb_threads; i++)
+      _threads.emplace_back(&ThreadPool::_worker, this, i);
+  }
+
+  ThreadPool::~ThreadPool()
+  {
+    wait();
+    {
+      std::lock_guard<std::mutex> lg(_mutex);
+      _stop = true;
+    }
+    _wake.notify_all();
+    for (auto& t : _threads)
+      t.join();
+  }
+
+  void ThreadPool::submit(task_t task)
+  {
+    size_t index = (current_pool == this) ? current_index : _next_queue++ % _queues.size();
+    _pending++;
+    {
+      // _queued is counted under the lock of the queue (as in _pop/_steal), so it never underflows; _mutex orders
+      // it with the wait of the idle workers (the lock order is always _mutex, then a queue)
+      std::lock_guard<std::mutex> lg(_mutex);
+      std::lock_guard<std::mutex> lq(_queues[index]->mutex);
+      _queues[index]->tasks.push_back(std::move(task));
+      _queued++;
+    }
+    _wake.notify_one();
+  }
+
+  void ThreadPool::wait()
+  {
+    std::unique_lock<std::mutex> lk(_mutex);
+    _idle.wait(lk, [this]() { return _pending == 0; });
+  }
+
+  void ThreadPool::parallel_for(size_t n, const std::function<void(size_t)>& f)
+  {
+    for (size_t i = 0; i < n; i++)
+      submit([&f, i]() { f(i); });
+    wait();
+  }
+
+  bool ThreadPool::_pop(size_t index, task_t& task)
+  {
+    std::lock_guard<std::mutex> lg(_queues[index]->mutex);
+    auto& tasks = _queues[index]->tasks;
+    if (tasks.empty())
+      return false;
+    task = std::move(tasks.back());
+    tasks.pop_back();
+    _queued--;
+    return true;
+  }
+
+  bool ThreadPool::_steal(size_t index, task_t& task)
+  {
+    for (size_t k = 1; k < _queues.size(); k++) {
+      auto& queue = *_queues[(index + k) % _queues.size()];
+      std::lock_guard<std::mutex> lg(queue.mutex);
+      if (queue.tasks.empty())
+	continue;
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      _queued--;
+      return true;
+    }
+    return false;
+  }
+
+  void ThreadPool::_worker(size_t index)
+  {
+    current_pool = this;
+    current_index = index;
+
+    while (true) {
+      task_t task;
+      if (_pop(index, task) || _steal(index, task)) {
+	task();
+	if (--_pending == 0) {
+	  std::lock_guard<std::mutex> lg(_mutex);
+	  _idle.notify_all();
+	}
+	continue;
+      }
+
+      std::unique_lock<std::mutex> lk(_mutex);
+      _wake.wait(lk, [this]() { return _stop || _queued > 0; });
+      if (_stop && _queued == 0)
+	return;
+    }
+  }
+} // namespace robox2d
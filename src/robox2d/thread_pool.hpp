@@ -0,0 +1,69 @@
+#ifndef ROBOX2D_THREAD_POOL_HPP
+#define ROBOX2D_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace robox2d {
+
+  /**
+   * @brief ThreadPool is a fixed pool of workers with one task queue per worker and work stealing.
+   *
+   * Tasks submitted from outside the pool are distributed round-robin over the workers. Tasks submitted
+   * from a worker go to its own queue (and are executed LIFO), idle workers steal the oldest tasks of the others.
+   * wait() must not be called from a task.
+   */
+  class ThreadPool {
+  public:
+    using task_t = std::function<void()>;
+
+    /**
+     * @brief Construct a new ThreadPool object
+     *
+     * @param  nb_threads number of workers (0 means std::thread::hardware_concurrency()).
+     */
+    explicit ThreadPool(size_t nb_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    void operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return _threads.size(); }
+
+    void submit(task_t task);
+    /* Block until every submitted task (including the ones submitted by tasks) is done */
+    void wait();
+
+    /* Run f(i) for i in [0, n) on the workers and wait for the result */
+    void parallel_for(size_t n, const std::function<void(size_t)>& f);
+
+  protected:
+    struct Queue {
+      std::deque<task_t> tasks;
+      std::mutex mutex;
+    };
+
+    void _worker(size_t index);
+    bool _pop(size_t index, task_t& task);
+    bool _steal(size_t index, task_t& task);
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _threads;
+
+    std::mutex _mutex;
+    std::condition_variable _wake; // signaled when a task is queued
+    std::condition_variable _idle; // signaled when all the tasks are done
+    std::atomic<size_t> _queued; // tasks waiting in a queue
+    std::atomic<size_t> _pending; // tasks queued or running
+    std::atomic<size_t> _next_queue;
+    bool _stop;
+  };
+} // namespace robox2d
+
+#endif
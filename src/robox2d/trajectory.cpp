@@ -0,0 +1,247 @@
+#include "trajectory.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "simu.hpp"
+
+namespace robox2d {
+  namespace trajectory {
+
+    static const char magic[8] = {'R', 'B', 'X', '2', 'T', 'R', 'A', 'J'};
+    static const uint32_t version = 2; // 2: the chunk index is aligned on 8 bytes
+
+    float joint_position(b2Joint* joint)
+    {
+      switch (joint->GetType()) {
+      case e_revoluteJoint:
+	return static_cast<b2RevoluteJoint*>(joint)->GetJointAngle();
+      case e_prismaticJoint:
+	return static_cast<b2PrismaticJoint*>(joint)->GetJointTranslation();
+      case e_wheelJoint:
+	return static_cast<b2WheelJoint*>(joint)->GetJointAngle();
+      default:
+	return 0.0f;
+      }
+    }
+
+    // Writer
+
+    Writer::Writer(const std::string& filename, size_t nb_bodies, size_t nb_joints, size_t nb_inputs, size_t chunk_frames) :
+      _file(filename, std::ios::binary | std::ios::trunc),
+      _closed(false),
+      _chunk_size(0)
+    {
+      assert(chunk_frames > 0 && "A chunk must hold at least one frame");
+      std::memset(&_header, 0, sizeof(Header));
+      std::memcpy(_header.magic, magic, sizeof(magic));
+      _header.version = version;
+      _header.nb_bodies = nb_bodies;
+      _header.nb_joints = nb_joints;
+      _header.nb_inputs = nb_inputs;
+      _header.chunk_frames = chunk_frames;
+
+      _time.resize(chunk_frames);
+      _x.resize(chunk_frames * nb_bodies);
+      _y.resize(chunk_frames * nb_bodies);
+      _angle.resize(chunk_frames * nb_bodies);
+      _joints.resize(chunk_frames * nb_joints);
+      _inputs.resize(chunk_frames * nb_inputs);
+
+      // the header is written again (complete) by close()
+      _file.write(reinterpret_cast<const char*>(&_header), sizeof(Header));
+    }
+
+    Writer::~Writer()
+    {
+      close();
+    }
+
+    void Writer::write(double time, const float* x, const float* y, const float* angle, const float* joints, const float* inputs)
+    {
+      assert(!_closed && "Writing in a closed trajectory");
+      const size_t nb = _header.nb_bodies, nj = _header.nb_joints, ni = _header.nb_inputs;
+      _time[_chunk_size] = time;
+      std::copy(x, x + nb, _x.begin() + _chunk_size * nb);
+      std::copy(y, y + nb, _y.begin() + _chunk_size * nb);
+      std::copy(angle, angle + nb, _angle.begin() + _chunk_size * nb);
+      std::copy(joints, joints + nj, _joints.begin() + _chunk_size * nj);
+      std::copy(inputs, inputs + ni, _inputs.begin() + _chunk_size * ni);
+      _header.nb_frames++;
+      if (++_chunk_size == _header.chunk_frames)
+	_flush_chunk();
+    }
+
+    void Writer::close()
+    {
+      if (_closed)
+	return;
+      _closed = true;
+      if (_chunk_size > 0)
+	_flush_chunk();
+
+      // the index is read in place (memory mapped): align it on 8 bytes
+      static const char padding[alignof(ChunkIndex)] = {};
+      const size_t end = _file.tellp();
+      _file.write(padding, (alignof(ChunkIndex) - end % alignof(ChunkIndex)) % alignof(ChunkIndex));
+
+      _header.nb_chunks = _index.size();
+      _header.index_offset = _file.tellp();
+      _file.write(reinterpret_cast<const char*>(_index.data()), _index.size() * sizeof(ChunkIndex));
+      _file.seekp(0);
+      _file.write(reinterpret_cast<const char*>(&_header), sizeof(Header));
+      _file.close();
+    }
+
+    void Writer::_flush_chunk()
+    {
+      ChunkIndex chunk;
+      chunk.offset = _file.tellp();
+      chunk.first_frame = _header.nb_frames - _chunk_size;
+      chunk.nb_frames = _chunk_size;
+      _index.push_back(chunk);
+
+      const size_t n = _chunk_size, nb = _header.nb_bodies;
+      _file.write(reinterpret_cast<const char*>(_time.data()), n * sizeof(double));
+      _file.write(reinterpret_cast<const char*>(_x.data()), n * nb * sizeof(float));
+      _file.write(reinterpret_cast<const char*>(_y.data()), n * nb * sizeof(float));
+      _file.write(reinterpret_cast<const char*>(_angle.data()), n * nb * sizeof(float));
+      _file.write(reinterpret_cast<const char*>(_joints.data()), n * _header.nb_joints * sizeof(float));
+      _file.write(reinterpret_cast<const char*>(_inputs.data()), n * _header.nb_inputs * sizeof(float));
+      _chunk_size = 0;
+    }
+
+    // Reader
+
+    Reader::Reader(const std::string& filename) :
+      _data(nullptr),
+      _size(0),
+      _index(nullptr)
+    {
+      std::memset(&_header, 0, sizeof(Header));
+      int fd = open(filename.c_str(), O_RDONLY);
+      if (fd < 0)
+	return;
+      struct stat st;
+      if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(Header))) {
+	void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data != MAP_FAILED) {
+	  _data = static_cast<const char*>(data);
+	  _size = st.st_size;
+	}
+      }
+      close(fd);
+      if (!_data)
+	return;
+
+      std::memcpy(&_header, _data, sizeof(Header));
+      if (!_check()) {
+	std::cout << "Warning: not a trajectory file (or not closed, or corrupted): " << filename << std::endl;
+	munmap(const_cast<char*>(_data), _size);
+	_data = nullptr;
+	_size = 0;
+	std::memset(&_header, 0, sizeof(Header));
+	return;
+      }
+      _index = reinterpret_cast<const ChunkIndex*>(_data + _header.index_offset);
+    }
+
+    bool Reader::_check() const
+    {
+      if (std::memcmp(_header.magic, magic, sizeof(magic)) != 0 || _header.version != version || _header.chunk_frames == 0)
+	return false;
+      // index in the file and aligned (sizes are checked by divisions to avoid overflows)
+      if (_header.index_offset < sizeof(Header) || _header.index_offset > _size
+	  || _header.index_offset % alignof(ChunkIndex) != 0
+	  || _header.nb_chunks > (_size - _header.index_offset) / sizeof(ChunkIndex))
+	return false;
+      if (_header.nb_chunks != (_header.nb_frames + _header.chunk_frames - 1) / _header.chunk_frames)
+	return false;
+
+      // every chunk inside the data part of the file (before the index), all full but the last one
+      const uint64_t frame_size = sizeof(double)
+	+ sizeof(float) * (3 * uint64_t(_header.nb_bodies) + _header.nb_joints + _header.nb_inputs);
+      const ChunkIndex* index = reinterpret_cast<const ChunkIndex*>(_data + _header.index_offset);
+      uint64_t nb_frames = 0;
+      for (uint64_t c = 0; c < _header.nb_chunks; c++) {
+	const ChunkIndex& chunk = index[c];
+	const bool last = c + 1 == _header.nb_chunks;
+	if (chunk.first_frame != nb_frames || chunk.nb_frames == 0 || chunk.nb_frames > _header.chunk_frames
+	    || (!last && chunk.nb_frames != _header.chunk_frames))
+	  return false;
+	if (chunk.offset < sizeof(Header) || chunk.offset > _header.index_offset
+	    || chunk.nb_frames > (_header.index_offset - chunk.offset) / frame_size)
+	  return false;
+	nb_frames += chunk.nb_frames;
+      }
+      return nb_frames == _header.nb_frames;
+    }
+
+    Reader::~Reader()
+    {
+      if (_data)
+	munmap(const_cast<char*>(_data), _size);
+    }
+
+    Reader::Frame Reader::frame(size_t index) const
+    {
+      assert(index < _header.nb_frames && "Frame index out of bounds");
+      // all the chunks but the last one are full
+      const ChunkIndex& chunk = _index[index / _header.chunk_frames];
+      const size_t n = chunk.nb_frames, k = index - chunk.first_frame;
+      const size_t nb = _header.nb_bodies, nj = _header.nb_joints, ni = _header.nb_inputs;
+
+      const char* p = _data + chunk.offset;
+      Frame frame;
+      std::memcpy(&frame.time, p + k * sizeof(double), sizeof(double));
+      const float* columns = reinterpret_cast<const float*>(p + n * sizeof(double));
+      frame.x = columns + k * nb;
+      frame.y = columns + n * nb + k * nb;
+      frame.angle = columns + 2 * n * nb + k * nb;
+      frame.joints = columns + 3 * n * nb + k * nj;
+      frame.inputs = columns + 3 * n * nb + n * nj + k * ni;
+      return frame;
+    }
+
+    void Reader::apply(b2World& world, size_t index) const
+    {
+      Frame f = frame(index);
+      size_t i = 0;
+      for (b2Body* body = world.GetBodyList(); body && i < _header.nb_bodies; body = body->GetNext(), i++)
+	body->SetTransform({f.x[i], f.y[i]}, f.angle[i]);
+      assert(i == _header.nb_bodies && "The world does not have the bodies of the trajectory");
+    }
+
+    size_t replay(Simu& simu, const Reader& reader, size_t first, size_t last, size_t stride)
+    {
+      assert(stride > 0 && "The stride of a replay must be at least one frame");
+      last = std::min(last, reader.nb_frames());
+      auto graphics = simu.graphics();
+      // shown at the recorded times when the simu is synced (with its real-time factor)
+      const bool sync = simu.get_sync();
+      Pacer& pacer = simu.pacer();
+      if (sync && first < last)
+	pacer.start(reader.frame(first).time);
+      size_t nb_shown = 0;
+      for (size_t i = first; i < last; i += stride) {
+	if (graphics && graphics->done())
+	  break;
+	if (sync)
+	  pacer.wait(reader.frame(i).time);
+	reader.apply(*simu.world(), i);
+	simu.invalidate_state();
+	if (graphics)
+	  graphics->refresh();
+	nb_shown++;
+      }
+      return nb_shown;
+    }
+  } // namespace trajectory
+} // namespace robox2d
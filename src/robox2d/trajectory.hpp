@@ -0,0 +1,135 @@
+#ifndef ROBOX2D_TRAJECTORY_HPP
+#define ROBOX2D_TRAJECTORY_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <box2d/box2d.h>
+
+namespace robox2d {
+  class Simu;
+
+  /**
+   * @brief Binary trajectory files (written by descriptor::TrajectoryRecorder).
+   *
+   * Layout (little endian):
+   *   - header: magic "RBX2TRAJ", version, number of bodies / joints / inputs, frames per chunk, number of frames,
+   *     number of chunks and offset of the chunk index (patched when the file is closed);
+   *   - chunks of up to chunk_frames frames, stored by columns: time (f64), then body x, y, angle, joint positions and
+   *     actuator inputs (f32, one row of nb_bodies / nb_joints / nb_inputs values per frame);
+   *   - padding to 8 bytes, then the chunk index: offset, first frame and number of frames of each chunk.
+   */
+  namespace trajectory {
+    struct Header {
+      char magic[8];
+      uint32_t version;
+      uint32_t nb_bodies;
+      uint32_t nb_joints;
+      uint32_t nb_inputs;
+      uint32_t chunk_frames;
+      uint32_t reserved;
+      uint64_t nb_frames;
+      uint64_t nb_chunks;
+      uint64_t index_offset;
+    };
+
+    struct ChunkIndex {
+      uint64_t offset;
+      uint64_t first_frame;
+      uint64_t nb_frames;
+    };
+
+    /* Position of a joint (angle of revolute/wheel joints, translation of prismatic joints, 0 otherwise) */
+    float joint_position(b2Joint* joint);
+
+    /**
+     * @brief Streams frames to a trajectory file, one chunk at a time.
+     */
+    class Writer {
+    public:
+      Writer(const std::string& filename, size_t nb_bodies, size_t nb_joints, size_t nb_inputs, size_t chunk_frames = 256);
+      ~Writer();
+
+      Writer(const Writer&) = delete;
+      Writer& operator=(const Writer&) = delete;
+
+      bool good() const { return _file.good(); }
+
+      /* Append one frame (bodies: 3 arrays of nb_bodies values; joints and inputs: nb_joints and nb_inputs values) */
+      void write(double time, const float* x, const float* y, const float* angle, const float* joints, const float* inputs);
+
+      /* Flush the last chunk, write the index and the header; called by the destructor */
+      void close();
+
+      size_t nb_frames() const { return _header.nb_frames; }
+
+    protected:
+      void _flush_chunk();
+
+      std::ofstream _file;
+      Header _header;
+      std::vector<ChunkIndex> _index;
+      bool _closed;
+
+      size_t _chunk_size; // frames in the current chunk
+      std::vector<double> _time;
+      std::vector<float> _x, _y, _angle, _joints, _inputs;
+    };
+
+    /**
+     * @brief Random access to a trajectory file (memory mapped).
+     */
+    class Reader {
+    public:
+      struct Frame {
+	double time;
+	const float* x;
+	const float* y;
+	const float* angle;
+	const float* joints;
+	const float* inputs;
+      };
+
+      Reader(const std::string& filename);
+      ~Reader();
+
+      Reader(const Reader&) = delete;
+      Reader& operator=(const Reader&) = delete;
+
+      /* False if the file could not be mapped or is not a (closed) trajectory file */
+      bool good() const { return _data != nullptr; }
+
+      size_t nb_frames() const { return _header.nb_frames; }
+      size_t nb_bodies() const { return _header.nb_bodies; }
+      size_t nb_joints() const { return _header.nb_joints; }
+      size_t nb_inputs() const { return _header.nb_inputs; }
+
+      Frame frame(size_t index) const;
+
+      /* Set the transforms of the bodies of the world (same bodies, in the order of the body list, as when recording) */
+      void apply(b2World& world, size_t index) const;
+
+    protected:
+      /* Header and chunk index consistent with the size of the file (frames are read without further checks) */
+      bool _check() const;
+
+      const char* _data;
+      size_t _size;
+      Header _header;
+      const ChunkIndex* _index;
+    };
+
+    /**
+     * @brief Show frames [first, last) of a trajectory with the graphics of the simu, without stepping the physics.
+     *
+     * The world of the simu must have the bodies of the recording. When the simu is synced, the frames are paced by
+     * its Pacer at their recorded times (with the real-time factor of the simu). Returns the number of frames shown
+     * (stops when the graphics are closed).
+     */
+    size_t replay(Simu& simu, const Reader& reader, size_t first = 0, size_t last = size_t(-1), size_t stride = 1);
+  } // namespace trajectory
+} // namespace robox2d
+
+#endif
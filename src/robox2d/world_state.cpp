@@ -0,0 +1,80 @@
+#include "world_state.hpp"
+
+#include <cassert>
+
+namespace robox2d {
+
+  constexpr size_t WorldStateCache::npos;
+
+  void WorldState::gather(const b2World& world)
+  {
+    bool changed = false;
+    const size_t n = world.GetBodyCount();
+    if (n != bodies.size()) {
+      _resize(n);
+      changed = true;
+    }
+    size_t i = 0;
+    for (const b2Body* body = world.GetBodyList(); body; body = body->GetNext(), i++) {
+      if (bodies[i] != body) {
+	bodies[i] = body;
+	changed = true;
+      }
+      const b2Transform& xf = body->GetTransform();
+      const b2Vec2& center = body->GetWorldCenter();
+      const b2Vec2& v = body->GetLinearVelocity();
+      x[i] = xf.p.x;
+      y[i] = xf.p.y;
+      angle[i] = body->GetAngle();
+      c[i] = xf.q.c;
+      s[i] = xf.q.s;
+      cx[i] = center.x;
+      cy[i] = center.y;
+      vx[i] = v.x;
+      vy[i] = v.y;
+      w[i] = body->GetAngularVelocity();
+      mass[i] = body->GetMass();
+    }
+    if (changed)
+      version++;
+  }
+
+  void WorldState::copy_to(WorldState& other) const
+  {
+    // assign() keeps the capacity of the destination
+    other.bodies.assign(bodies.begin(), bodies.end());
+    for (auto member : {&WorldState::x, &WorldState::y, &WorldState::angle, &WorldState::c, &WorldState::s, &WorldState::cx,
+	  &WorldState::cy, &WorldState::vx, &WorldState::vy, &WorldState::w, &WorldState::mass})
+      (other.*member).assign((this->*member).begin(), (this->*member).end());
+    other.version = version;
+  }
+
+  void WorldState::_resize(size_t size)
+  {
+    bodies.resize(size, nullptr);
+    for (auto member : {&WorldState::x, &WorldState::y, &WorldState::angle, &WorldState::c, &WorldState::s, &WorldState::cx,
+	  &WorldState::cy, &WorldState::vx, &WorldState::vy, &WorldState::w, &WorldState::mass})
+      (this->*member).resize(size);
+  }
+
+  size_t WorldStateCache::index(const b2Body* body) const
+  {
+    const WorldState& state = get();
+    if (!_indices_valid || _indices_version != state.version) {
+      _indices.clear();
+      for (size_t i = 0; i < state.size(); i++)
+	_indices[state.bodies[i]] = i;
+      _indices_version = state.version;
+      _indices_valid = true;
+    }
+    auto it = _indices.find(body);
+    return it == _indices.end() ? npos : it->second;
+  }
+
+  void WorldStateCache::_refresh() const
+  {
+    assert(_world && "WorldStateCache without world");
+    _state.gather(*_world);
+    _valid = true;
+  }
+} // namespace robox2d
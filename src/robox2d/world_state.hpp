@@ -0,0 +1,72 @@
+#ifndef ROBOX2D_WORLD_STATE_HPP
+#define ROBOX2D_WORLD_STATE_HPP
+
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <box2d/box2d.h>
+
+namespace robox2d {
+
+  /**
+   * @brief State of all the bodies of a world, in the order of the body list, as a structure of arrays.
+   *
+   * x, y, angle (and its cosine c / sine s) are the transform of the body origin, cx, cy the center of mass,
+   * vx, vy, w the linear (of the center of mass) and angular velocities.
+   */
+  struct WorldState {
+    std::vector<const b2Body*> bodies;
+    std::vector<float> x, y, angle, c, s, cx, cy, vx, vy, w, mass;
+    size_t version = 0; // incremented when the body list changes
+
+    size_t size() const { return bodies.size(); }
+
+    /* Read the state of all the bodies of world */
+    void gather(const b2World& world);
+
+    /* Copy into other, reusing its memory (no allocation once other is large enough) */
+    void copy_to(WorldState& other) const;
+
+  protected:
+    void _resize(size_t size);
+  };
+
+  /**
+   * @brief WorldState of a world gathered on demand, at most once between two invalidations (see Simu::world_state).
+   */
+  class WorldStateCache {
+  public:
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    WorldStateCache(const b2World* world = nullptr) : _world(world) {}
+
+    void set_world(const b2World* world) { _world = world; _valid = false; }
+
+    /* The state, gathered if it was invalidated since the last call */
+    const WorldState& get() const
+    {
+      if (!_valid)
+	_refresh();
+      return _state;
+    }
+
+    void invalidate() { _valid = false; }
+    bool valid() const { return _valid; }
+
+    /* Index of a body in the state (npos if it is not in the world) */
+    size_t index(const b2Body* body) const;
+
+  protected:
+    void _refresh() const;
+
+    const b2World* _world;
+    mutable WorldState _state;
+    mutable bool _valid = false;
+    mutable std::unordered_map<const b2Body*, size_t> _indices;
+    mutable size_t _indices_version = 0;
+    mutable bool _indices_valid = false;
+  };
+} // namespace robox2d
+
+#endif
@@ -0,0 +1,183 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE action_log
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+
+#include <boost/test/unit_test.hpp>
+
+#include <robox2d/action_log.hpp>
+#include <robox2d/hash.hpp>
+
+#include "../benchmarks/bench_robots.hpp"
+
+namespace {
+  class Sine : public robox2d::control::BaseController {
+  public:
+    Sine(size_t nb_dofs) : BaseController(nb_dofs) {}
+
+    void write_commands(double t, robox2d::Robot* robot, Eigen::Ref<Eigen::VectorXd> cmd) override
+    {
+      for (size_t i = 0; i < _nb_dofs; i++)
+	cmd[i] = 0.5 * std::sin(2.0 * t + i);
+    }
+  };
+
+  std::shared_ptr<robox2d::Simu> make_simu()
+  {
+    auto simu = std::make_shared<robox2d::Simu>(100, 50, 50);
+    simu->add_floor();
+    auto rob = std::make_shared<bench::Arm>(simu->world(), 4);
+    rob->add_controller(std::make_shared<Sine>(4));
+    simu->add_robot(rob);
+    return simu;
+  }
+
+  std::shared_ptr<robox2d::ActionLog> record(double duration, uint64_t& final_hash)
+  {
+    auto simu = make_simu();
+    auto log = std::make_shared<robox2d::ActionLog>();
+    log->seed = 1;
+    simu->set_action_logger(std::make_shared<robox2d::ActionLogger>(robox2d::ActionLogger::Record, log));
+    simu->run(duration);
+    final_hash = robox2d::world_hash(*simu->world());
+    return log;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(command_encoding_is_lossless)
+{
+  const size_t size = 5, nb_ticks = 100;
+  std::mt19937_64 gen(0);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  std::vector<double> commands(size * nb_ticks);
+  for (size_t k = 0; k < nb_ticks; k++)
+    for (size_t i = 0; i < size; i++)
+      commands[k * size + i] = (i == 0) ? 0.25 : (i == 1 ? dist(gen) : std::sin(0.01 * k + i));
+  commands[3] = -0.0;
+  commands[4] = std::numeric_limits<double>::quiet_NaN();
+
+  robox2d::CommandEncoder encoder;
+  encoder.reset(size);
+  std::vector<uint8_t> data;
+  for (size_t k = 0; k < nb_ticks; k++)
+    encoder.encode(&commands[k * size], data);
+
+  robox2d::CommandDecoder decoder;
+  decoder.reset(size);
+  std::vector<double> decoded(size * nb_ticks);
+  const uint8_t* p = data.data();
+  for (size_t k = 0; k < nb_ticks && p; k++)
+    p = decoder.decode(p, data.data() + data.size(), &decoded[k * size]);
+
+  BOOST_CHECK(p == data.data() + data.size());
+  BOOST_CHECK(std::memcmp(commands.data(), decoded.data(), commands.size() * sizeof(double)) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(truncated_commands_are_rejected)
+{
+  const double cmd[2] = {0.5, -1.25};
+  robox2d::CommandEncoder encoder;
+  encoder.reset(2);
+  std::vector<uint8_t> data;
+  encoder.encode(cmd, data);
+
+  robox2d::CommandDecoder decoder;
+  decoder.reset(2);
+  double decoded[2] = {0.0, 0.0};
+  for (size_t size = 0; size < data.size(); size++)
+    BOOST_CHECK(decoder.decode(data.data(), data.data() + size, decoded) == nullptr);
+  BOOST_CHECK_EQUAL(decoded[0], 0.0);
+
+  // invalid header: more stripped bytes than a double has
+  std::vector<uint8_t> invalid = {0x55, 0x00};
+  BOOST_CHECK(decoder.decode(invalid.data(), invalid.data() + invalid.size(), decoded) == nullptr);
+
+  BOOST_CHECK(decoder.decode(data.data(), data.data() + data.size(), decoded) == data.data() + data.size());
+  BOOST_CHECK_EQUAL(decoded[1], -1.25);
+}
+
+BOOST_AUTO_TEST_CASE(corrupted_log_is_rejected)
+{
+  const std::string filename = "test_action_log_corrupted.bin";
+  uint64_t final_hash = 0;
+  auto log = record(1.0, final_hash);
+
+  // commands missing at the end of a stream
+  auto truncated = std::make_shared<robox2d::ActionLog>(*log);
+  truncated->robots[0].data.pop_back();
+  BOOST_REQUIRE(truncated->save(filename));
+  robox2d::ActionLog loaded;
+  BOOST_CHECK(!loaded.load(filename));
+
+  // more ticks than the data holds
+  auto ticks = std::make_shared<robox2d::ActionLog>(*log);
+  ticks->robots[0].nb_ticks++;
+  BOOST_REQUIRE(ticks->save(filename));
+  BOOST_CHECK(!loaded.load(filename));
+
+  // truncated file (the sizes of the vectors are larger than the rest of the file)
+  BOOST_REQUIRE(log->save(filename));
+  std::vector<char> bytes;
+  {
+    std::ifstream in(filename, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), bytes.size() / 2);
+  }
+  BOOST_CHECK(!loaded.load(filename));
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(replay_is_bit_for_bit)
+{
+  const double duration = 20.0;
+  const std::string filename = "test_action_log.bin";
+  uint64_t final_hash = 0;
+  auto log = record(duration, final_hash);
+  BOOST_REQUIRE(log->save(filename));
+
+  auto loaded = std::make_shared<robox2d::ActionLog>();
+  BOOST_REQUIRE(loaded->load(filename));
+  std::remove(filename.c_str());
+  BOOST_CHECK_EQUAL(loaded->hashes.size(), log->hashes.size());
+  BOOST_CHECK_EQUAL(loaded->hashes.running(), log->hashes.running());
+
+  auto simu = make_simu();
+  auto replayer = std::make_shared<robox2d::ActionLogger>(robox2d::ActionLogger::Replay, loaded);
+  simu->set_action_logger(replayer);
+  robox2d::RunResult result = simu->run(duration);
+
+  BOOST_CHECK_EQUAL(result.reason, robox2d::RunResult::Duration);
+  BOOST_CHECK_EQUAL(replayer->divergence(), robox2d::ActionLogger::npos);
+  BOOST_CHECK_EQUAL(robox2d::world_hash(*simu->world()), final_hash);
+}
+
+BOOST_AUTO_TEST_CASE(perturbation_is_detected)
+{
+  const double duration = 20.0;
+  uint64_t final_hash = 0;
+  auto log = record(duration, final_hash);
+
+  auto simu = make_simu();
+  auto replayer = std::make_shared<robox2d::ActionLogger>(robox2d::ActionLogger::Replay, log);
+  simu->set_action_logger(replayer);
+  BOOST_REQUIRE_EQUAL(simu->run(duration / 2).reason, robox2d::RunResult::Duration);
+  b2Body* body = simu->world()->GetBodyList();
+  body->SetLinearVelocity(body->GetLinearVelocity() + b2Vec2(1e-6f, 0.0f));
+  const size_t perturbation_tick = simu->tick();
+  robox2d::RunResult result = simu->run(duration / 2);
+
+  // detected at the first hashed physic step after the perturbation
+  const size_t ticks_per_hash = log->hash_period * std::llround(simu->physic_period() * simu->tick_freq());
+  BOOST_CHECK_EQUAL(result.reason, robox2d::RunResult::Diverged);
+  BOOST_CHECK_GT(replayer->divergence_tick(), perturbation_tick);
+  BOOST_CHECK_LE(replayer->divergence_tick(), perturbation_tick + ticks_per_hash);
+}
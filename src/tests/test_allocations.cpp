@@ -0,0 +1,120 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE allocations
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <boost/test/unit_test.hpp>
+
+#include "../benchmarks/bench_robots.hpp"
+
+// Count the heap allocations of the program. Eigen allocates with std::malloc, not operator new: with glibc,
+// malloc itself is interposed so both are counted.
+static std::atomic<size_t> nb_allocations(0);
+
+#if defined(__GLIBC__)
+extern "C" {
+  void* __libc_malloc(std::size_t size);
+  void* __libc_calloc(std::size_t nb, std::size_t size);
+  void* __libc_realloc(void* p, std::size_t size);
+
+  void* malloc(std::size_t size)
+  {
+    nb_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+  }
+
+  void* calloc(std::size_t nb, std::size_t size)
+  {
+    nb_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(nb, size);
+  }
+
+  void* realloc(void* p, std::size_t size)
+  {
+    nb_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+  }
+}
+#else
+// elsewhere, only operator new is seen (the allocations of Eigen are missed)
+void* operator new(std::size_t size)
+{
+  nb_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
+
+namespace {
+  // let the contacts and the Box2D allocators settle
+  void warm_up(robox2d::Simu& simu) { simu.run(5.0); }
+
+  // allocations of nb control updates of the robots (sensors and controllers)
+  size_t control_allocations(robox2d::Simu& simu, size_t nb)
+  {
+    size_t before = nb_allocations;
+    for (size_t k = 0; k < nb; k++)
+      for (auto& robot : simu.robots()) {
+	robot->sensor_update();
+	robot->control_update(simu.time());
+      }
+    return nb_allocations - before;
+  }
+
+  // allocations of nb physic steps (actuators and world step, without the scheduling of Simu::run)
+  size_t physic_allocations(robox2d::Simu& simu, size_t nb)
+  {
+    size_t before = nb_allocations;
+    for (size_t k = 0; k < nb; k++) {
+      for (auto& robot : simu.robots())
+	robot->physic_update();
+      simu.world()->Step(simu.physic_period(), 6, 2);
+    }
+    return nb_allocations - before;
+  }
+
+  // allocations of a run of Simu::run (control and physic steps together)
+  size_t run_allocations(robox2d::Simu& simu, double duration)
+  {
+    size_t before = nb_allocations;
+    simu.run(duration);
+    return nb_allocations - before;
+  }
+
+  void check_no_allocation(const std::shared_ptr<robox2d::Simu>& simu)
+  {
+    warm_up(*simu);
+    BOOST_CHECK_EQUAL(control_allocations(*simu, 500), 0u);
+    BOOST_CHECK_EQUAL(physic_allocations(*simu, 500), 0u);
+    BOOST_CHECK_EQUAL(run_allocations(*simu, 5.0), 0u);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(hook_counts_eigen_allocations)
+{
+  size_t before = nb_allocations;
+  Eigen::VectorXd v = Eigen::VectorXd::Random(100);
+  BOOST_CHECK_GE(nb_allocations - before, 1u);
+  BOOST_CHECK_GT(v.squaredNorm(), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(arm_steps_do_not_allocate)
+{
+  check_no_allocation(bench::make_arm_simu());
+}
+
+BOOST_AUTO_TEST_CASE(car_steps_do_not_allocate)
+{
+  check_no_allocation(bench::make_car_simu());
+}
+
+BOOST_AUTO_TEST_CASE(lunar_lander_steps_do_not_allocate)
+{
+  check_no_allocation(bench::make_lunar_lander_simu());
+}
@@ -0,0 +1,96 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE hash
+
+#include <cmath>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+#include <robox2d/hash.hpp>
+
+#include "../benchmarks/bench_robots.hpp"
+
+namespace {
+  std::shared_ptr<robox2d::Simu> make_arms_simu(size_t nb_arms)
+  {
+    auto simu = std::make_shared<robox2d::Simu>(100, 50, 50);
+    simu->add_floor();
+    for (size_t i = 0; i < nb_arms; i++) {
+      auto rob = std::make_shared<bench::Arm>(simu->world(), 4, b2Vec2(3.0f * i, 0.0f));
+      rob->add_controller(std::make_shared<robox2d::control::ConstantPos>(bench::arm_target(4)));
+      simu->add_robot(rob);
+    }
+    return simu;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(first_divergence_of_streams)
+{
+  robox2d::HashStream a, b;
+  for (uint64_t t = 0; t < 10; t++) {
+    a.push_back(2 * t, t);
+    b.push_back(2 * t, t == 6 ? 100 : t);
+  }
+  BOOST_CHECK_EQUAL(robox2d::first_divergence(a, a), robox2d::no_divergence);
+  BOOST_CHECK_EQUAL(robox2d::first_divergence(a, b), 12u);
+  BOOST_CHECK(a.running() != b.running());
+
+  // a prefix does not diverge
+  robox2d::HashStream prefix;
+  for (size_t i = 0; i < 4; i++)
+    prefix.push_back(a[i].tick, a[i].hash);
+  BOOST_CHECK_EQUAL(robox2d::first_divergence(a, prefix), robox2d::no_divergence);
+}
+
+BOOST_AUTO_TEST_CASE(world_hash_is_bitwise)
+{
+  auto simu = make_arms_simu(1);
+  const uint64_t hash = robox2d::world_hash(*simu->world());
+  BOOST_CHECK_EQUAL(robox2d::world_hash(*simu->world()), hash);
+
+  b2Body* body = simu->world()->GetBodyList();
+  body->SetAngularVelocity(-0.0f);
+  const uint64_t negative_zero = robox2d::world_hash(*simu->world());
+  body->SetAngularVelocity(0.0f);
+  BOOST_CHECK(negative_zero != robox2d::world_hash(*simu->world()));
+}
+
+BOOST_AUTO_TEST_CASE(clones_in_threads_are_identical)
+{
+  const double duration = 10.0;
+  auto reference = make_arms_simu(8);
+  reference->enable_state_hash();
+  std::vector<std::shared_ptr<robox2d::Simu>> clones;
+  for (size_t i = 0; i < 4; i++)
+    clones.push_back(reference->clone());
+
+  // the last clone gets a perturbation half way
+  size_t perturbation_tick = 0;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < clones.size(); i++)
+    threads.emplace_back([&clones, &perturbation_tick, i, duration]() {
+      if (i == clones.size() - 1) {
+	clones[i]->run(duration / 2);
+	perturbation_tick = clones[i]->tick();
+	b2Body* body = clones[i]->world()->GetBodyList();
+	body->SetAngularVelocity(body->GetAngularVelocity() + 1e-6f);
+	clones[i]->run(duration / 2);
+      }
+      else
+	clones[i]->run(duration);
+    });
+  for (auto& t : threads)
+    t.join();
+
+  BOOST_REQUIRE_GT(clones[0]->state_hashes().size(), 0u);
+  for (size_t i = 1; i + 1 < clones.size(); i++) {
+    BOOST_CHECK_EQUAL(robox2d::first_divergence(clones[0]->state_hashes(), clones[i]->state_hashes()), robox2d::no_divergence);
+    BOOST_CHECK_EQUAL(clones[0]->state_hashes().running(), clones[i]->state_hashes().running());
+  }
+
+  // hashed at every physic step: caught at the first step after the perturbation
+  size_t tick = robox2d::first_divergence(clones[0]->state_hashes(), clones.back()->state_hashes());
+  const size_t ticks_per_step = std::llround(clones[0]->physic_period() * clones[0]->tick_freq());
+  BOOST_CHECK_GT(tick, perturbation_tick);
+  BOOST_CHECK_LE(tick, perturbation_tick + ticks_per_step);
+}
@@ -0,0 +1,136 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE rasterizer
+
+#include <boost/test/unit_test.hpp>
+
+#include <robox2d/common.hpp>
+#include <robox2d/gui/instance_builder.hpp>
+#include <robox2d/rasterizer.hpp>
+#include <robox2d/sensor.hpp>
+#include <robox2d/simu.hpp>
+
+using robox2d::Rasterizer;
+
+namespace {
+  // Is p inside a drawn fixture (the reference of the rasterizer: not ignore, not a sensor, polygons and circles)?
+  bool inside(b2World& world, const b2Vec2& p, const b2Body* ignore)
+  {
+    for (b2Body* body = world.GetBodyList(); body; body = body->GetNext()) {
+      if (body == ignore)
+	continue;
+      for (b2Fixture* f = body->GetFixtureList(); f; f = f->GetNext())
+	if (!f->IsSensor() && (f->GetType() == b2Shape::e_circle || f->GetType() == b2Shape::e_polygon) && f->TestPoint(p))
+	  return true;
+    }
+    return false;
+  }
+
+  // Is p within eps of the boundary of a shape (where the rounding of the scanlines may decide either way)?
+  bool near_boundary(b2World& world, const b2Vec2& p, const b2Body* ignore, float eps = 1e-3f)
+  {
+    bool in = inside(world, p, ignore);
+    const b2Vec2 offsets[4] = {{eps, 0.0f}, {-eps, 0.0f}, {0.0f, eps}, {0.0f, -eps}};
+    for (const b2Vec2& d : offsets)
+      if (inside(world, p + d, ignore) != in)
+	return true;
+    return false;
+  }
+
+  // Cells of the grid (channel 0) that differ from the brute-force point-in-shape test of their center
+  size_t nb_wrong_cells(const Rasterizer& raster, b2World& world, const b2Vec2& center, float angle, const b2Body* ignore,
+			const float* cells, size_t& nb_filled)
+  {
+    const b2Rot rot(angle);
+    size_t nb_wrong = 0;
+    nb_filled = 0;
+    for (size_t row = 0; row < raster.height(); row++)
+      for (size_t col = 0; col < raster.width(); col++) {
+	b2Vec2 local((col + 0.5f - 0.5f * raster.width()) / raster.resolution(),
+		     (0.5f * raster.height() - row - 0.5f) / raster.resolution());
+	b2Vec2 p = center + b2Mul(rot, local);
+	bool filled = cells[(row * raster.width() + col) * raster.channels()] > 0.0f;
+	nb_filled += filled;
+	if (filled != inside(world, p, ignore) && !near_boundary(world, p, ignore))
+	  nb_wrong++;
+      }
+    return nb_wrong;
+  }
+
+  std::shared_ptr<robox2d::Simu> make_world()
+  {
+    auto simu = std::make_shared<robox2d::Simu>(100, 50, 50);
+    auto world = simu->world();
+    robox2d::common::createBox(world, {0.73f, 0.31f}, b2_staticBody, {1.13f, 0.57f, 0.4f});
+    robox2d::common::createBox(world, {0.27f, 0.52f}, b2_staticBody, {-1.41f, -0.83f, 0.0f});
+    robox2d::common::createCircle(world, 0.61f, b2_staticBody, {-0.93f, 1.07f, 0.0f});
+    robox2d::common::createCircle(world, 0.17f, b2_dynamicBody, {0.37f, -1.21f, 0.0f});
+    return simu;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(filled_cells_match_shapes)
+{
+  auto simu = make_world();
+  Rasterizer raster(64, 48, 16.0f);
+  raster.set_view({0.11f, 0.07f});
+  raster.clear();
+  raster.draw_world(*simu->world());
+
+  size_t nb_filled = 0;
+  BOOST_CHECK_EQUAL(nb_wrong_cells(raster, *simu->world(), {0.11f, 0.07f}, 0.0f, nullptr, raster.data().data(), nb_filled), 0u);
+  BOOST_CHECK_GT(nb_filled, 0u);
+  BOOST_CHECK_EQUAL(raster.nb_drawn(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(rotated_view)
+{
+  auto simu = make_world();
+  const b2Vec2 center(-0.23f, 0.19f);
+  for (float angle : {0.3f, 1.1f, -2.4f}) {
+    Rasterizer raster(40, 56, 12.0f);
+    raster.set_view(center, angle);
+    raster.clear();
+    raster.draw_world(*simu->world());
+    size_t nb_filled = 0;
+    BOOST_CHECK_EQUAL(nb_wrong_cells(raster, *simu->world(), center, angle, nullptr, raster.data().data(), nb_filled), 0u);
+    BOOST_CHECK_GT(nb_filled, 0u);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(egocentric_sensor_ignores_its_body_and_sensor_fixtures)
+{
+  auto simu = make_world();
+  auto world = simu->world();
+  b2Body* body = robox2d::common::createBox(world, {0.2f, 0.1f}, b2_dynamicBody, {0.13f, 0.21f, 0.8f});
+  // a sensor fixture covering part of the grid is not drawn either
+  b2Body* trigger = robox2d::common::createCircle(world, 0.4f, b2_staticBody, {0.9f, -0.4f, 0.0f});
+  trigger->GetFixtureList()->SetSensor(true);
+
+  robox2d::sensor::OccupancyGrid grid(body, 48, 48, 16.0f);
+  std::vector<double> obs(grid.size());
+  grid.update(obs.data());
+  std::vector<float> cells(obs.begin(), obs.end());
+
+  size_t nb_filled = 0;
+  BOOST_CHECK_EQUAL(nb_wrong_cells(grid.rasterizer(), *world, body->GetPosition(), body->GetAngle(), body, cells.data(), nb_filled), 0u);
+  BOOST_CHECK_GT(nb_filled, 0u);
+  // the center of the grid is on the body: not drawn
+  BOOST_CHECK_EQUAL(cells[24 * 48 + 24], 0.0f);
+}
+
+BOOST_AUTO_TEST_CASE(camera_colors)
+{
+  auto simu = make_world();
+  Rasterizer raster(64, 64, 16.0f, 3);
+  raster.set_view({-0.93f, 1.07f}); // centered on the large circle
+  raster.clear();
+  raster.draw_world(*simu->world());
+
+  using robox2d::gui::InstanceBuilder;
+  const std::array<float, 3> color = InstanceBuilder::default_color(InstanceBuilder::Circle);
+  const float* cell = raster.data().data() + (32 * 64 + 32) * 3;
+  for (size_t c = 0; c < 3; c++)
+    BOOST_CHECK_EQUAL(cell[c], color[c]);
+  // background in the corners
+  BOOST_CHECK_EQUAL(raster.data()[0], 0.0f);
+}
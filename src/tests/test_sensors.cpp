@@ -0,0 +1,126 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE sensors
+
+#include <cmath>
+#include <random>
+
+#include <boost/test/unit_test.hpp>
+
+#include <robox2d/sensor.hpp>
+
+#include "../benchmarks/bench_robots.hpp"
+
+namespace {
+  // Reference: closest hit of one b2World::RayCast, with the filters of RaySensor
+  struct ClosestHit : public b2RayCastCallback {
+    float ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction) override
+    {
+      if (fixture->GetBody() == ignore || fixture->IsSensor() || !(fixture->GetFilterData().categoryBits & mask_bits))
+	return -1.0f;
+      closest = fraction;
+      return fraction;
+    }
+
+    b2Body* ignore = nullptr;
+    uint16 mask_bits = 0xFFFF;
+    float closest = 1.0f;
+  };
+
+  std::vector<double> cast_one_by_one(b2World& world, const robox2d::sensor::RaySensor& sensor)
+  {
+    ClosestHit callback;
+    callback.ignore = sensor.body();
+    callback.mask_bits = sensor.mask_bits();
+    const b2Transform& xf = sensor.body()->GetTransform();
+    std::vector<double> obs;
+    for (const b2Vec2& dir : sensor.directions()) {
+      b2Vec2 p1 = b2Mul(xf, sensor.anchor());
+      b2Vec2 p2 = p1 + sensor.max_range() * b2Mul(xf.q, dir);
+      callback.closest = 1.0f;
+      world.RayCast(&callback, p1, p2);
+      obs.push_back(callback.closest * sensor.max_range());
+    }
+    return obs;
+  }
+
+  std::shared_ptr<robox2d::Simu> make_world()
+  {
+    auto simu = std::make_shared<robox2d::Simu>(100, 50, 50);
+    auto world = simu->world();
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<float> pos(-10.0f, 10.0f), size(0.1f, 0.5f);
+    for (size_t i = 0; i < 200; i++) {
+      if (i % 2)
+	robox2d::common::createBox(world, {size(gen), size(gen)}, b2_staticBody, {pos(gen), pos(gen), pos(gen)});
+      else
+	robox2d::common::createCircle(world, size(gen), b2_staticBody, {pos(gen), pos(gen), 0.0f});
+    }
+    return simu;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(batched_rays_match_world_raycast)
+{
+  const float max_range = 5.0f;
+  auto simu = make_world();
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<float> pos(-10.0f, 10.0f);
+  for (size_t i = 0; i < 10; i++) {
+    auto robot = std::make_shared<robox2d::Robot>();
+    b2Body* body = robox2d::common::createCircle(simu->world(), 0.1f, b2_dynamicBody, {pos(gen), pos(gen), pos(gen)});
+    robot->add_sensor(std::make_shared<robox2d::sensor::Lidar>(body, b2Vec2(0.05f, 0.0f), 360, 2.0f * b2_pi, max_range));
+    robot->add_sensor(std::make_shared<robox2d::sensor::Rangefinder>(body, b2Vec2(0.0f, 0.0f), 0.3f, max_range));
+    simu->add_robot(robot);
+  }
+
+  size_t nb_hits = 0;
+  for (auto& robot : simu->robots()) {
+    robot->sensor_update();
+    const Eigen::VectorXd& obs = robot->observations();
+    size_t offset = 0;
+    for (auto& sensor : robot->sensors()) {
+      auto ray_sensor = std::static_pointer_cast<robox2d::sensor::RaySensor>(sensor);
+      std::vector<double> expected = cast_one_by_one(*simu->world(), *ray_sensor);
+      BOOST_REQUIRE_LE(offset + expected.size(), size_t(obs.size()));
+      for (size_t r = 0; r < expected.size(); r++) {
+	BOOST_CHECK_SMALL(obs[offset + r] - expected[r], 1e-4);
+	nb_hits += expected[r] < max_range;
+      }
+      offset += expected.size();
+    }
+  }
+  // the obstacles are actually seen
+  BOOST_CHECK_GT(nb_hits, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(ray_filters)
+{
+  auto simu = make_world();
+  auto world = simu->world();
+  b2Body* body = robox2d::common::createCircle(world, 0.1f, b2_dynamicBody, {50.0f, 50.0f, 0.0f});
+  robox2d::sensor::Rangefinder rangefinder(body, b2Vec2(0.0f, 0.0f), 0.0f, 2.0f);
+
+  // nothing in range (the body itself is ignored)
+  double obs = 0.0;
+  rangefinder.update(&obs);
+  BOOST_CHECK_EQUAL(obs, 2.0);
+
+  // a wall 1 m ahead
+  b2Body* wall = robox2d::common::createBox(world, {0.1f, 1.0f}, b2_staticBody, {51.1f, 50.0f, 0.0f});
+  rangefinder.update(&obs);
+  BOOST_CHECK_CLOSE(obs, 1.0, 1e-3);
+
+  // filtered out by the mask
+  b2Filter filter;
+  filter.categoryBits = 0x0002;
+  wall->GetFixtureList()->SetFilterData(filter);
+  rangefinder.set_mask_bits(0x0001);
+  rangefinder.update(&obs);
+  BOOST_CHECK_EQUAL(obs, 2.0);
+
+  // sensor fixtures are ignored
+  rangefinder.set_mask_bits(0xFFFF);
+  wall->GetFixtureList()->SetSensor(true);
+  rangefinder.update(&obs);
+  BOOST_CHECK_EQUAL(obs, 2.0);
+}